@@ -2,7 +2,11 @@
 // Created by jiayi on 2/9/2025.
 //
 
+#include <algorithm>
 #include <cstdint>
+#include <format>
+#include <span>
+#include <unordered_set>
 #include <ranges>
 #include <vector>
 
@@ -10,10 +14,13 @@
 
 #include "dual_contouring.h"
 #include "engine/data_type.h"
+#include "engine/frame_statistics.h"
 #include "sdf_surface.h"
 #include "util/check.h"
+#include "util/hash.hpp"
 #include "world/gameobject.hpp"
 #include "world/mesh.h"
+#include "world/transform.h"
 
 
 namespace Vkxel {
@@ -35,16 +42,56 @@ namespace Vkxel {
 
         SDFSurface &sdf_surface = sdf_surface_result.value();
         _sdf = sdf_surface.GetSDF();
+        _batch_sdf = sdf_surface.GetBatchSDF();
 
         const glm::ivec3 grid_size = glm::ivec3((maxBound - minBound) * resolution);
         std::vector<std::vector<std::vector<float>>> grid(
                 grid_size.x, std::vector<std::vector<float>>(grid_size.y, std::vector<float>(grid_size.z)));
 
-        for (int x = 0; x < grid_size.x; ++x) {
-            for (int y = 0; y < grid_size.y; ++y) {
-                for (int z = 0; z < grid_size.z; ++z) {
-                    glm::vec3 position = Grid2World({x, y, z});
-                    grid[x][y][z] = _sdf(position);
+        if (enableSampleCache) {
+            std::vector<glm::vec3> position(static_cast<size_t>(std::max(grid_size.x * grid_size.y * grid_size.z, 0)));
+            for (int x = 0; x < grid_size.x; ++x) {
+                for (int y = 0; y < grid_size.y; ++y) {
+                    for (int z = 0; z < grid_size.z; ++z) {
+                        position[(x * grid_size.y + y) * grid_size.z + z] = Grid2World({x, y, z});
+                    }
+                }
+            }
+
+            uint64_t lattice_key = Hash::Value(minBound);
+            lattice_key = Hash::Value(resolution, lattice_key);
+            lattice_key = Hash::Value(grid_size, lattice_key);
+
+            std::unordered_set<IdType> visited;
+            const auto &root = SampleNode(sdf_surface, glm::mat4{1.0f}, 1.0f, lattice_key, position, visited);
+            std::erase_if(_sample_cache, [&](const auto &entry) { return !visited.contains(entry.first); });
+
+            for (int x = 0; x < grid_size.x; ++x) {
+                for (int y = 0; y < grid_size.y; ++y) {
+                    for (int z = 0; z < grid_size.z; ++z) {
+                        grid[x][y][z] = root.value[(x * grid_size.y + y) * grid_size.z + z];
+                    }
+                }
+            }
+        } else {
+            _sample_cache.clear();
+
+            // Sample one x slice per batch call
+            std::vector<glm::vec3> slice_position(static_cast<size_t>(std::max(grid_size.y * grid_size.z, 0)));
+            std::vector<float> slice_value(slice_position.size());
+            for (int x = 0; x < grid_size.x; ++x) {
+                for (int y = 0; y < grid_size.y; ++y) {
+                    for (int z = 0; z < grid_size.z; ++z) {
+                        slice_position[y * grid_size.z + z] = Grid2World({x, y, z});
+                    }
+                }
+
+                _batch_sdf(slice_position, slice_value);
+
+                for (int y = 0; y < grid_size.y; ++y) {
+                    for (int z = 0; z < grid_size.z; ++z) {
+                        grid[x][y][z] = slice_value[y * grid_size.z + z];
+                    }
                 }
             }
         }
@@ -164,10 +211,74 @@ namespace Vkxel {
             gameObject.AddComponent<Mesh>();
         }
 
+        MesherStatistics::AddTriangles(std::format("{} ({})", gameObject.name, name), indices.size() / 3);
+
         Mesh &mesh = gameObject.GetComponent<Mesh>().value();
         mesh.SetMesh(CPUMeshData{.index = std::move(indices), .vertex = std::move(vertices)});
     }
 
+    const DualContouring::SampleCacheEntry &
+    DualContouring::SampleNode(const SDFSurface &node, const glm::mat4 &rootToNode, const float scale,
+                               const uint64_t latticeKey, std::span<const glm::vec3> position,
+                               std::unordered_set<IdType> &visited) {
+        visited.insert(node.id);
+
+        uint64_t key = Hash::Value(rootToNode, latticeKey);
+        key = Hash::Value(scale, key);
+
+        if (node.surfaceType == SurfaceType::CSG && node.csgType != CSGType::None) {
+            // Combine from child grids, only children whose key changed are resampled
+            std::vector<const SampleCacheEntry *> child_entry;
+            key = Hash::Value(node.GetSignature(), key);
+            for (const auto &child_wrapper: node.gameObject.transform.GetChildren()) {
+                Transform &child = child_wrapper;
+                if (auto child_sdf_surface = child.gameObject.GetComponent<SDFSurface>()) {
+                    float child_minimum_scale = std::min({child.scale.x, child.scale.y, child.scale.z});
+                    glm::mat4 root_to_child = child.GetRelativeToLocalMatrix() * rootToNode;
+                    const auto &entry = SampleNode(child_sdf_surface.value(), root_to_child,
+                                                   scale * child_minimum_scale, latticeKey, position, visited);
+                    key = Hash::Value(entry.key, key);
+                    child_entry.push_back(&entry);
+                }
+            }
+
+            SampleCacheEntry &entry = _sample_cache[node.id];
+            if (entry.key == key && entry.value.size() == position.size()) {
+                return entry;
+            }
+
+            entry.key = key;
+            entry.value.assign(position.size(), SDFSurface::GetCSGEmptyValue(node.csgType));
+            // Smooth CSG is homogeneous in scale only when the smooth factor is scaled as well
+            for (size_t index = 0; index < child_entry.size(); ++index) {
+                SDFSurface::CombineCSG(node.csgType, node.csgSmoothFactor * scale, index, child_entry[index]->value,
+                                       entry.value);
+            }
+            return entry;
+        }
+
+        // Leaf or repetition node, sampled directly with its whole subtree
+        key = Hash::Value(node.GetSubtreeSignature(), key);
+
+        SampleCacheEntry &entry = _sample_cache[node.id];
+        if (entry.key == key && entry.value.size() == position.size()) {
+            return entry;
+        }
+
+        std::vector<glm::vec3> node_position(position.size());
+        for (size_t index = 0; index < position.size(); ++index) {
+            node_position[index] = rootToNode * glm::vec4{position[index], 1.0f};
+        }
+
+        entry.key = key;
+        entry.value.resize(position.size());
+        node.GetBatchSDF()(node_position, entry.value);
+        for (auto &value: entry.value) {
+            value *= scale;
+        }
+        return entry;
+    }
+
     glm::vec3 DualContouring::CalculateNormal(const glm::vec3 &position) const {
         glm::vec3 x_delta = {normalDelta, 0, 0};
         glm::vec3 y_delta = {0, normalDelta, 0};
@@ -6,8 +6,13 @@
 #define VKXEL_DUAL_CONTOURING_H
 
 #include <array>
+#include <cstdint>
 #include <functional>
+#include <span>
+#include <unordered_map>
+#include <unordered_set>
 #include <utility>
+#include <vector>
 
 #include "glm/glm.hpp"
 
@@ -30,16 +35,32 @@ namespace Vkxel {
         uint32_t schmitzIterationCount = 20;
         float schmitzStepSize = 0.1f;
 
+        // Keep each SDF subtree's samples over the lattice and only resample subtrees whose signature changed
+        bool enableSampleCache = false;
+
         void Create() override;
         void Update() override;
 
         void GenerateMesh();
 
     private:
+        struct SampleCacheEntry {
+            uint64_t key = 0;
+            std::vector<float> value;
+        };
+
+        // Sample node over the lattice in root space, rootToNode and scale accumulate the transforms of GetChildSDF
+        const SampleCacheEntry &SampleNode(const SDFSurface &node, const glm::mat4 &rootToNode, float scale,
+                                           uint64_t latticeKey, std::span<const glm::vec3> position,
+                                           std::unordered_set<IdType> &visited);
+
         glm::vec3 CalculateNormal(const glm::vec3 &position) const;
         glm::vec3 Grid2World(const glm::vec3 &index) const;
 
         SDFType _sdf;
+        SDFBatchType _batch_sdf;
+
+        std::unordered_map<IdType, SampleCacheEntry> _sample_cache;
 
         static constexpr std::array<glm::ivec3, 8> _voxel_point{
                 {{0, 0, 0}, {1, 0, 0}, {1, 0, 1}, {0, 0, 1}, {0, 1, 0}, {1, 1, 0}, {1, 1, 1}, {0, 1, 1}}};
@@ -65,6 +86,7 @@ namespace Vkxel {
         REGISTER_DATA(normalDelta)
         REGISTER_DATA(schmitzIterationCount)
         REGISTER_DATA(schmitzStepSize)
+        REGISTER_DATA(enableSampleCache)
         REGISTER_END()
     };
 
@@ -2,17 +2,29 @@
 // Created by jiayi on 2/9/2025.
 //
 
+#include <algorithm>
+#include <bit>
 #include <cstdint>
+#include <format>
 #include <span>
+#include <string>
 #include <vector>
 
 #include "glm/glm.hpp"
 
+#include "engine/compute_graph.h"
 #include "engine/data_type.h"
 #include "engine/engine.h"
+#include "engine/frame_statistics.h"
+#include "engine/gpu_profiler.h"
 #include "engine/vtime.h"
+#include "engine/shader.h"
 #include "gpu_dual_contouring.h"
+#include "sdf_shader_generator.h"
 #include "sdf_surface.h"
+#include "sdf_tape.h"
+#include "util/check.h"
+#include "util/hash.hpp"
 #include "world/gameobject.hpp"
 #include "world/mesh.h"
 
@@ -23,72 +35,309 @@ namespace Vkxel {
     void GpuDualContouring::Update() {
         if (enableUpdate) {
             GenerateMesh();
+        } else if (_pending_timeline_value > 0 && _compute->IsComplete(_pending_timeline_value)) {
+            // Nothing regenerates the mesh, so an overflowed submission is rerun here instead of drawing empty
+            UpdateConsumerTimeline();
+            if (ResolvePending()) {
+                ResubmitCompaction();
+            }
         }
     }
 
 
     void GpuDualContouring::GenerateMesh() {
-        auto sdf_surface_result = gameObject.GetComponent<SDFSurface>();
-        if (!sdf_surface_result) {
-            sdf_surface_result = gameObject.AddComponent<SDFSurface>();
-        }
-
-        SDFSurface &sdf_surface = sdf_surface_result.value();
-
-        // GPU SDF is currently hard-coded in compute shader
-        sdf_surface.surfaceType = SurfaceType::Primitive;
-        sdf_surface.primitiveType = PrimitiveType::Sphere;
-        _sdf = sdf_surface.GetSDF();
-
         if (!_compute) {
             _compute = Engine::GetActiveEngine()->GetRenderer().CreateComputeJob();
+            _profile_zone = std::format("{} ({})", gameObject.name, name);
+            _compute->SetProfileZone(_profile_zone);
         }
 
         ComputeJob &compute_job = _compute.value();
 
+        UpdateConsumerTimeline();
+
+        // Buffers of the previous asynchronous submission are rewritten below, so it has to finish first
+        if (_pending_timeline_value > 0) {
+            ResolvePending();
+        }
+
         const glm::ivec3 grid_size = glm::ivec3((maxBound - minBound) * resolution);
 
-        if (minBound != _min_bound_cache || maxBound != _max_bound_cache || resolution != _resolution_cache) {
+        Time rebuild_timer;
+        rebuild_timer.Start();
+
+        // Without an SDFSurface the hard-coded SDF in compute shader is used
+        std::string shader = "compute";
+        uint64_t shader_hash = 0;
+        std::vector<SDFShaderGenerator::NodeData> node_data;
+        std::vector<SDFTape::Instruction> tape_instructions;
+        std::string generated_shader;
+
+        if (auto sdf_surface_result = gameObject.GetComponent<SDFSurface>()) {
+            const SDFSurface &sdf_surface = sdf_surface_result.value();
+            if (sdfMode == GpuSDFMode::Generated) {
+                SDFShaderGenerator generator(sdf_surface);
+                shader = generator.GetName();
+                generated_shader = shader;
+                shader_hash = generator.GetHash();
+                node_data = generator.GetNodeData();
+                if (!ShaderLoader::Instance().HasSource(shader)) {
+                    ShaderLoader::Instance().RegisterSource(shader, generator.GetSource());
+                }
+            } else {
+                SDFTape tape(sdf_surface);
+                shader = "sdf_tape";
+                shader_hash = Hash::String(shader);
+                node_data = tape.GetNodeData();
+                tape_instructions = tape.GetInstructions();
+            }
+        }
+
+        // Every structure edit makes a new shader, the previous one would otherwise stay registered and on disk
+        if (generated_shader != _generated_shader) {
+            if (!_generated_shader.empty()) {
+                ShaderLoader::Instance().UnregisterSource(_generated_shader);
+            }
+            _generated_shader = generated_shader;
+        }
+
+        // Pipelines only depend on the shader, the kernel variant and which SDF buffers are bound
+        const bool has_node_buffer = !node_data.empty();
+        const bool has_tape_buffer = !tape_instructions.empty();
+        const bool rebuild_pipeline = !compute_job.HasPipeline() || shader_hash != _shader_hash_cache ||
+                                      useTiledKernel != _tiled_kernel_cache ||
+                                      threadPerGroup != _thread_per_group_cache ||
+                                      has_node_buffer != (_node_capacity > 0) ||
+                                      has_tape_buffer != (_tape_capacity > 0);
+        if (rebuild_pipeline) {
+            CHECK(glm::all(glm::greaterThan(threadPerGroup, glm::uvec3{0})), "Thread Per Group Must Be Positive");
+            CHECK(!useTiledKernel || glm::all(glm::lessThanEqual(threadPerGroup,
+                                                                  glm::uvec3{_max_tile_thread_per_dimension})),
+                  "Tiled Kernel Support At Most {} Thread Per Dimension", _max_tile_thread_per_dimension);
+
+            _shader_hash_cache = shader_hash;
+            _tiled_kernel_cache = useTiledKernel;
+            _thread_per_group_cache = threadPerGroup;
+
+            std::vector<std::string_view> kernel = {"DualContouringStep0", "DualContouringStep1",
+                                                    "DualContouringStep2", "DualContouringStep3",
+                                                    "DualContouringStep4", "DualContouringStep5",
+                                                    "DualContouringStep3Block", "DualContouringClear"};
+            if (useTiledKernel) {
+                kernel[1] = "DualContouringStep1Tiled";
+                kernel[4] = "DualContouringStep4Tiled";
+                kernel[5] = "DualContouringStep5Tiled";
+            }
+
+            const size_t buffer_count = 6 + has_node_buffer + has_tape_buffer;
+            compute_job.InitPipeline(shader, kernel, buffer_count,
+                                     {threadPerGroup.x, threadPerGroup.y, threadPerGroup.z},
+                                     sizeof(DualContouringArguments));
+        }
+
+        // Buffers come from size classes that only grow, so bound and resolution edits mostly rewrite descriptors,
+        // node and tape buffers grow geometrically so tape edits rarely outgrow them
+        if (rebuild_pipeline || minBound != _min_bound_cache || maxBound != _max_bound_cache ||
+            resolution != _resolution_cache || enableCompactGrid != _compact_grid_cache ||
+            node_data.size() > _node_capacity || tape_instructions.size() > _tape_capacity) {
             _min_bound_cache = minBound;
             _max_bound_cache = maxBound;
             _resolution_cache = resolution;
+            _compact_grid_cache = enableCompactGrid;
+            _node_capacity = has_node_buffer ? std::bit_ceil(node_data.size()) : 0;
+            _tape_capacity = has_tape_buffer ? std::bit_ceil(tape_instructions.size()) : 0;
+            _vertex_capacity = std::max(_vertex_capacity, _min_vertex_capacity);
+            _index_capacity = std::max(_index_capacity, _vertex_capacity * 6);
 
             uint32_t grid_elem_num = grid_size.x * grid_size.y * grid_size.z;
+            uint32_t scan_group_num = (grid_elem_num + _scan_group_size - 1) / _scan_group_size;
+            uint32_t scan_block_num = (scan_group_num + _scan_group_size - 1) / _scan_group_size;
+            // Point counts are packed into a word per _point_per_word points, with one prefix word beside each
+            uint32_t point_word_num = (grid_elem_num + _point_per_word - 1) / _point_per_word;
+
+            // Compact grid packs two fp16 distances per word along z, an eighth of the float4 grid
+            uint32_t compact_grid_elem_num = grid_size.x * grid_size.y * ((grid_size.z + 1) / 2);
+            VkDeviceSize grid_buffer_size = enableCompactGrid ? sizeof(uint32_t) * compact_grid_elem_num
+                                                              : sizeof(glm::vec4) * grid_elem_num;
+
+            std::vector<VkDeviceSize> buffer_size = {sizeof(DualContouringResults),
+                                                     grid_buffer_size,
+                                                     sizeof(uint32_t) * 2 * point_word_num,
+                                                     sizeof(VertexType) * _vertex_capacity,
+                                                     sizeof(IndexType) * _index_capacity,
+                                                     sizeof(glm::uvec2) * (scan_group_num + scan_block_num)};
+            std::vector<ComputeBufferUsage> buffer_usage = {
+                    ComputeBufferUsage::Shared, ComputeBufferUsage::Scratch, ComputeBufferUsage::Scratch,
+                    ComputeBufferUsage::Output, ComputeBufferUsage::Output,  ComputeBufferUsage::Scratch};
+            if (has_node_buffer) {
+                buffer_size.push_back(sizeof(SDFShaderGenerator::NodeData) * _node_capacity);
+                buffer_usage.push_back(ComputeBufferUsage::Upload);
+            }
+            if (has_tape_buffer) {
+                buffer_size.push_back(sizeof(SDFTape::Instruction) * _tape_capacity);
+                buffer_usage.push_back(ComputeBufferUsage::Upload);
+            }
+
+            compute_job.InitBuffer(buffer_size, buffer_usage);
+        }
+
+        // Transforms and tape are uploaded every time so scene edits do not need a recompile
+        if (!node_data.empty()) {
+            compute_job.WriteBuffer(SDFShaderGenerator::NodeBufferBinding,
+                                    reinterpret_cast<const std::byte *>(node_data.data()), 0,
+                                    sizeof(SDFShaderGenerator::NodeData) * node_data.size());
+        }
+        if (!tape_instructions.empty()) {
+            compute_job.WriteBuffer(SDFTape::TapeBufferBinding,
+                                    reinterpret_cast<const std::byte *>(tape_instructions.data()), 0,
+                                    sizeof(SDFTape::Instruction) * tape_instructions.size());
+        }
+
+        rebuild_timer.Stop();
+        _rebuild_milliseconds = rebuild_timer.GetRealElapsedSeconds() * 1000.0f;
+
+        _arguments = {.gridSize = grid_size,
+                      .minBound = minBound,
+                      .maxBound = maxBound,
+                      .normalDelta = normalDelta,
+                      .schmitzIterationCount = schmitzIterationCount,
+                      .schmitzStepSize = schmitzStepSize,
+                      .time = Time::GetSeconds(),
+                      .compactGrid = enableCompactGrid,
+                      .vertexCapacity = _vertex_capacity,
+                      .indexCapacity = _index_capacity};
+        DualContouringResults results = {.draw = {.instanceCount = 1}};
+        // Results are shared memory and always mapped, arguments go through staging without ReBAR
+        compute_job.SetPushConstant(_arguments);
+        compute_job.GetMappedBuffer<DualContouringResults>(0)[0] = results;
+        compute_job.FlushBuffer(0);
+
+        // Vertex and index slots come from a prefix sum over per point counts, so the output order is deterministic
+        const uint32_t grid_elem_num = grid_size.x * grid_size.y * grid_size.z;
+        glm::uvec3 group_size = GetGroupSize(grid_size, threadPerGroup);
+        glm::uvec3 grid_group_size =
+                enableCompactGrid ? GetGroupSize({grid_size.x, grid_size.y, (grid_size.z + 1) / 2}, threadPerGroup)
+                                  : group_size;
+        // Points are scanned per group, group totals per block of groups and block totals in a single group,
+        // the group scan is dispatched in rows since large grids exceed maxComputeWorkGroupCount[0]
+        const uint32_t scan_group_num = (grid_elem_num + _scan_group_size - 1) / _scan_group_size;
+        const uint32_t scan_block_num = (scan_group_num + _scan_group_size - 1) / _scan_group_size;
+        glm::uvec3 scan_group_size = {std::min(scan_group_num, _scan_dispatch_width),
+                                      (scan_group_num + _scan_dispatch_width - 1) / _scan_dispatch_width, 1};
+        // Packed point counts are accumulated atomically, so they are cleared first in rows of the same width
+        const uint32_t clear_group_num =
+                ((grid_elem_num + _point_per_word - 1) / _point_per_word + _scan_group_size - 1) / _scan_group_size;
+        glm::uvec3 clear_group_size = {std::min(clear_group_num, _scan_dispatch_width),
+                                       (clear_group_num + _scan_dispatch_width - 1) / _scan_dispatch_width, 1};
+        // Buffers: 0 results, 1 grid, 2 grid offset, 3 vertices, 4 indices, 5 group and block offset,
+        // vertex and index generation only share reads so they run in one batch
+        _compaction_node = {
+                {.kernel = 7, .group = clear_group_size, .write = {2}},
+                {.kernel = 1, .group = group_size, .read = {1}, .write = {2}},
+                {.kernel = 2, .group = scan_group_size, .write = {2, 5}},
+                {.kernel = 3, .group = {scan_block_num, 1, 1}, .write = {5}},
+                {.kernel = 6, .group = {1, 1, 1}, .write = {5, 0}},
+                {.kernel = 4, .group = group_size, .read = {1, 2, 5}, .write = {3}},
+                {.kernel = 5, .group = group_size, .read = {1, 2, 5}, .write = {4}}};
 
-            compute_job.Init("compute", {"DualContouringStep0", "DualContouringStep1", "DualContouringStep2"},
-                             {sizeof(DualContouringArguments), sizeof(DualContouringResults),
-                              sizeof(glm::vec4) * grid_elem_num, sizeof(uint32_t) * grid_elem_num,
-                              sizeof(VertexType) * grid_elem_num, sizeof(uint32_t) * grid_elem_num * 18});
+        ComputeGraph graph(compute_job);
+        graph.AddNode({.kernel = 0, .group = grid_group_size, .write = {1}}).AddNode(_compaction_node);
+
+        if (enableAsyncCompute) {
+            // The graphics queue waits for the returned value before drawing the output buffers
+            _pending_timeline_value = compute_job.Submit(graph);
+        } else {
+            compute_job.DispatchImmediate(graph);
+
+            // The submission is already complete, so reading the few result bytes does not add a stall
+            compute_job.InvalidateBuffer(0);
+            results = compute_job.GetMappedBuffer<DualContouringResults>(0)[0];
+            if (GrowOutput(results)) {
+                // Rerun compaction only, the SDF grid is still valid
+                _arguments.vertexCapacity = _vertex_capacity;
+                _arguments.indexCapacity = _index_capacity;
+                compute_job.SetPushConstant(_arguments);
+                compute_job.DispatchImmediate(ComputeGraph(compute_job).AddNode(_compaction_node));
+
+                compute_job.InvalidateBuffer(0);
+                results = compute_job.GetMappedBuffer<DualContouringResults>(0)[0];
+            }
+            AddTriangleStatistics(results);
         }
 
-        DualContouringArguments arguments = {.gridSize = grid_size,
-                                             .minBound = minBound,
-                                             .maxBound = maxBound,
-                                             .normalDelta = normalDelta,
-                                             .schmitzIterationCount = schmitzIterationCount,
-                                             .schmitzStepSize = schmitzStepSize,
-                                             .time = Time::GetSeconds()};
-        DualContouringResults results = {};
-        compute_job.WriteBuffer(0, reinterpret_cast<std::byte *>(&arguments));
-        compute_job.WriteBuffer(1, reinterpret_cast<std::byte *>(&results));
-
-        glm::uvec3 group_size = GetGroupSize(grid_size, _thread_per_group);
-        compute_job.DispatchImmediate(0, group_size);
-        compute_job.DispatchImmediate(1, group_size);
-        compute_job.DispatchImmediate(2, group_size);
-
-        compute_job.ReadBuffer(1, reinterpret_cast<std::byte *>(&results));
-
-        // Assign Vertex and Index to Mesh Component
+        AssignMesh();
+    }
+
+    void GpuDualContouring::AssignMesh() {
+        ComputeJob &compute_job = _compute.value();
+
+        // Assign Vertex and Index to Mesh Component, the draw count stays on GPU in the results buffer
         if (!gameObject.GetComponent<Mesh>()) {
             gameObject.AddComponent<Mesh>();
         }
 
         Mesh &mesh = gameObject.GetComponent<Mesh>().value();
-        mesh.SetMesh(GPUMeshData{.indexCount = results.indexCount,
-                                 .vertexCount = results.vertexCount,
-                                 .index = compute_job.GetBuffer(5),
-                                 .vertex = compute_job.GetBuffer(4)});
+        mesh.SetMesh(GPUMeshData{.indexCount = _index_capacity,
+                                 .vertexCount = _vertex_capacity,
+                                 .index = compute_job.GetBuffer(4),
+                                 .vertex = compute_job.GetBuffer(3),
+                                 .indirect = compute_job.GetBuffer(0),
+                                 .semaphore = enableAsyncCompute ? compute_job.GetTimelineSemaphore() : nullptr,
+                                 .semaphoreValue = _pending_timeline_value});
+    }
+
+    bool GpuDualContouring::ResolvePending() {
+        ComputeJob &compute_job = _compute.value();
+        compute_job.Wait(_pending_timeline_value);
+        _pending_timeline_value = 0;
+
+        compute_job.InvalidateBuffer(0);
+        const DualContouringResults pending_results = compute_job.GetMappedBuffer<DualContouringResults>(0)[0];
+        AddTriangleStatistics(pending_results);
+        return GrowOutput(pending_results);
+    }
+
+    void GpuDualContouring::ResubmitCompaction() {
+        ComputeJob &compute_job = _compute.value();
+        _arguments.vertexCapacity = _vertex_capacity;
+        _arguments.indexCapacity = _index_capacity;
+        compute_job.SetPushConstant(_arguments);
+        _pending_timeline_value = compute_job.Submit(ComputeGraph(compute_job).AddNode(_compaction_node));
+
+        // The grown buffers are new, so the mesh is reassigned
+        AssignMesh();
+    }
+
+    void GpuDualContouring::UpdateConsumerTimeline() {
+        // Rewriting or resizing the output buffers waits for every frame that may still draw them
+        const Renderer &renderer = Engine::GetActiveEngine()->GetRenderer();
+        _compute->SetConsumerTimeline(renderer.GetFrameTimelineSemaphore(), renderer.GetSubmittedFrameValue());
+    }
+
+    float GpuDualContouring::GetRebuildMilliseconds() const { return _rebuild_milliseconds; }
+
+    std::optional<double> GpuDualContouring::GetDispatchMilliseconds() const {
+        if (_profile_zone.empty()) {
+            return std::nullopt;
+        }
+        return GpuProfiler::Instance().GetLastMilliseconds(_profile_zone);
+    }
+
+    void GpuDualContouring::AddTriangleStatistics(const DualContouringResults &results) const {
+        MesherStatistics::AddTriangles(std::format("{} ({})", gameObject.name, name), results.draw.indexCount / 3);
+    }
+
+    bool GpuDualContouring::GrowOutput(const DualContouringResults &results) {
+        if (results.vertexCount <= _vertex_capacity && results.requiredIndexCount <= _index_capacity) {
+            return false;
+        }
+
+        ComputeJob &compute_job = _compute.value();
+        _vertex_capacity = std::max(_vertex_capacity, std::bit_ceil(results.vertexCount));
+        _index_capacity = std::max(_index_capacity, std::bit_ceil(results.requiredIndexCount));
+        compute_job.ResizeBuffer(3, sizeof(VertexType) * _vertex_capacity);
+        compute_job.ResizeBuffer(4, sizeof(IndexType) * _index_capacity);
+        return true;
     }
 
     size_t GpuDualContouring::GetIndex1D(const glm::ivec3 &size, const glm::ivec3 &index) {
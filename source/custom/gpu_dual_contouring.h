@@ -7,15 +7,26 @@
 
 #include <array>
 #include <functional>
+#include <optional>
+#include <string>
+#include <vector>
 
 #include "glm/glm.hpp"
 
 #include "engine/compute.h"
+#include "engine/compute_graph.h"
 #include "sdf_surface.h"
 #include "world/component.h"
 
 namespace Vkxel {
 
+    enum class GpuSDFMode {
+        // Compile the SDF tree into a shader, fastest to evaluate but structure edits rebuild the pipelines
+        Generated,
+        // Interpret the SDF tree from a storage buffer, edits never rebuild the pipelines
+        Tape,
+    };
+
     class GpuDualContouring final : public Component {
     public:
         using Component::Component;
@@ -30,15 +41,34 @@ namespace Vkxel {
         uint32_t schmitzIterationCount = 20;
         float schmitzStepSize = 0.1f;
 
+        GpuSDFMode sdfMode = GpuSDFMode::Generated;
+
+        // Store distance as fp16 and evaluate normals on demand, an eighth of the full float4 grid
+        bool enableCompactGrid = true;
+
+        // Stage grid corners through groupshared memory, tiled kernels support up to 8 threads per dimension
+        bool useTiledKernel = true;
+        glm::uvec3 threadPerGroup = {4, 4, 4};
+
+        // Submit to the compute queue without waiting, the renderer waits on the timeline semaphore on device,
+        // output growth is detected once the submission completes and the overflowed mesh draws empty meanwhile
+        bool enableAsyncCompute = true;
+
         void Start() override;
         void Update() override;
 
         void GenerateMesh();
 
+        // Host time of the last GenerateMesh spent on shader generation, pipeline creation and uploads
+        float GetRebuildMilliseconds() const;
+        // GPU time of the latest submission read back by GpuProfiler, empty while profiling is disabled
+        std::optional<double> GetDispatchMilliseconds() const;
+
     private:
         size_t GetIndex1D(const glm::ivec3 &size, const glm::ivec3 &index);
         glm::uvec3 GetGroupSize(const glm::uvec3 &thread, const glm::uvec3 &threadPerGroup);
 
+        // Push constant block of every kernel, 64 bytes within the guaranteed 128
         struct DualContouringArguments {
             glm::uvec3 gridSize;
             glm::vec3 minBound;
@@ -47,23 +77,65 @@ namespace Vkxel {
             uint32_t schmitzIterationCount;
             float schmitzStepSize;
             float time;
+            uint32_t compactGrid;
+            uint32_t vertexCapacity;
+            uint32_t indexCapacity;
         };
 
+        // Starts with VkDrawIndexedIndirectCommand so the buffer can be drawn indirectly without readback
         struct DualContouringResults {
+            VkDrawIndexedIndirectCommand draw;
             uint32_t vertexCount;
-            uint32_t indexCount;
+            uint32_t requiredIndexCount;
         };
 
+        // Grow output capacities geometrically to fit results, return true when the output buffers were resized
+        bool GrowOutput(const DualContouringResults &results);
+        // Wait for the pending asynchronous submission, count its triangles and grow the output to fit,
+        // return true when it overflowed
+        bool ResolvePending();
+        // Rerun compaction into the grown output, the SDF grid of the last submission is still valid
+        void ResubmitCompaction();
+        // Frames submitted so far may still draw the output buffers
+        void UpdateConsumerTimeline();
+        // Hand the output buffers to the Mesh component, the draw count stays on GPU in the results buffer
+        void AssignMesh();
+        // Asynchronous results are counted when read back on the next update
+        void AddTriangleStatistics(const DualContouringResults &results) const;
+
         glm::vec3 _min_bound_cache = {};
         glm::vec3 _max_bound_cache = {};
         float _resolution_cache = 0;
-
-        const glm::uvec3 _thread_per_group = {4, 4, 4};
+        uint64_t _shader_hash_cache = 0;
+        // Generated shader registered by this component, evicted when the tree structure changes
+        std::string _generated_shader;
+        bool _compact_grid_cache = false;
+        bool _tiled_kernel_cache = false;
+        glm::uvec3 _thread_per_group_cache = {};
+        size_t _node_capacity = 0;
+        size_t _tape_capacity = 0;
+        // Output buffers are sized from the surface occupancy and only grow
+        uint32_t _vertex_capacity = 0;
+        uint32_t _index_capacity = 0;
+        // Timeline value of the last asynchronous submission, 0 when nothing is in flight
+        uint64_t _pending_timeline_value = 0;
+        // Arguments and compaction passes of the last submission, reused when it has to be rerun
+        DualContouringArguments _arguments = {};
+        std::vector<ComputeGraph::Node> _compaction_node;
+
+        float _rebuild_milliseconds = 0;
+        std::string _profile_zone;
+
+        // Must match TILE_CAPACITY in shader/dual_contouring.slang
+        const uint32_t _max_tile_thread_per_dimension = 8;
+        // Must match SCAN_GROUP_SIZE, SCAN_DISPATCH_WIDTH and POINT_PER_WORD in shader/dual_contouring.slang
+        const uint32_t _scan_group_size = 256;
+        const uint32_t _scan_dispatch_width = 1024;
+        const uint32_t _point_per_word = 8;
+        const uint32_t _min_vertex_capacity = 1 << 12;
 
         std::optional<ComputeJob> _compute = std::nullopt;
 
-        SDFType _sdf;
-
         REGISTER_BEGIN(GpuDualContouring)
         REGISTER_BASE(Component)
         REGISTER_DATA(enableUpdate)
@@ -73,6 +145,11 @@ namespace Vkxel {
         REGISTER_DATA(normalDelta)
         REGISTER_DATA(schmitzIterationCount)
         REGISTER_DATA(schmitzStepSize)
+        REGISTER_DATA(sdfMode)
+        REGISTER_DATA(enableCompactGrid)
+        REGISTER_DATA(useTiledKernel)
+        REGISTER_DATA(threadPerGroup)
+        REGISTER_DATA(enableAsyncCompute)
         REGISTER_END()
     };
 
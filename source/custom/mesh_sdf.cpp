@@ -0,0 +1,470 @@
+//
+// Created by jiayi on 10/19/2026.
+//
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cmath>
+#include <limits>
+#include <map>
+#include <memory>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "glm/glm.hpp"
+
+#include "mesh_sdf.h"
+#include "util/check.h"
+
+namespace Vkxel {
+
+    MeshSDFBaker::MeshSDFBaker(const CPUMeshData &mesh) {
+        CHECK(mesh.index.size() % 3 == 0, "Mesh Index Count Must Be Multiple Of 3");
+
+        WeldVertices(mesh);
+        BuildPseudoNormals();
+        BuildBVH();
+    }
+
+    SDFVolume MeshSDFBaker::Bake(const glm::vec3 &minBound, const glm::vec3 &maxBound, const float resolution) const {
+        CHECK(resolution > 0, "Resolution Must Be Positive");
+
+        SDFVolume volume = {.size = glm::uvec3(glm::ceil((maxBound - minBound) * resolution)) + glm::uvec3{1},
+                            .minBound = minBound,
+                            .resolution = resolution};
+        volume.value.resize(static_cast<size_t>(volume.size.x) * volume.size.y * volume.size.z);
+
+        // Voxels outside the narrow band are left as infinity and solved by fast sweeping
+        const float max_distance =
+                enableFastSweeping ? narrowBand / resolution : std::numeric_limits<float>::max();
+        std::vector<uint8_t> frozen(volume.value.size(), 0);
+
+        const uint32_t thread_count =
+                threadCount > 0 ? threadCount : std::max(1u, std::thread::hardware_concurrency());
+        std::atomic<uint32_t> next_slice = 0;
+
+        auto bake_slice = [&]() {
+            for (uint32_t x = next_slice++; x < volume.size.x; x = next_slice++) {
+                for (uint32_t y = 0; y < volume.size.y; ++y) {
+                    for (uint32_t z = 0; z < volume.size.z; ++z) {
+                        const glm::uvec3 index = {x, y, z};
+                        const float distance = GetDistance(minBound + glm::vec3(index) / resolution, max_distance);
+                        const size_t index_1d = volume.GetIndex1D(index);
+                        if (distance == std::numeric_limits<float>::max()) {
+                            volume.value[index_1d] = std::numeric_limits<float>::infinity();
+                        } else {
+                            volume.value[index_1d] = distance;
+                            frozen[index_1d] = 1;
+                        }
+                    }
+                }
+            }
+        };
+
+        std::vector<std::thread> workers;
+        workers.reserve(thread_count - 1);
+        for (uint32_t index = 1; index < thread_count; ++index) {
+            workers.emplace_back(bake_slice);
+        }
+        bake_slice();
+        for (auto &worker: workers) {
+            worker.join();
+        }
+
+        if (enableFastSweeping) {
+            FastSweeping(volume, frozen);
+
+            // Regions not connected to the narrow band fall back to exact distance
+            for (uint32_t x = 0; x < volume.size.x; ++x) {
+                for (uint32_t y = 0; y < volume.size.y; ++y) {
+                    for (uint32_t z = 0; z < volume.size.z; ++z) {
+                        const glm::uvec3 index = {x, y, z};
+                        if (std::isinf(volume.GetValue(index))) {
+                            volume.SetValue(index, GetDistance(minBound + glm::vec3(index) / resolution));
+                        }
+                    }
+                }
+            }
+        }
+
+        return volume;
+    }
+
+    SDFVolume MeshSDFBaker::Bake(const float resolution, const uint32_t paddingVoxels) const {
+        CHECK(!_position.empty(), "Mesh Has No Vertex");
+        CHECK(resolution > 0, "Resolution Must Be Positive");
+
+        glm::vec3 min_bound = _position.front();
+        glm::vec3 max_bound = _position.front();
+        for (const glm::vec3 &position: _position) {
+            min_bound = glm::min(min_bound, position);
+            max_bound = glm::max(max_bound, position);
+        }
+
+        const glm::vec3 padding = glm::vec3(static_cast<float>(paddingVoxels) / resolution);
+        return Bake(min_bound - padding, max_bound + padding, resolution);
+    }
+
+    float MeshSDFBaker::GetDistance(const glm::vec3 &position, const float maxDistance) const {
+        if (_bvh.empty()) {
+            return std::numeric_limits<float>::max();
+        }
+
+        float best_distance2 = maxDistance == std::numeric_limits<float>::max()
+                                       ? std::numeric_limits<float>::infinity()
+                                       : maxDistance * maxDistance;
+        glm::vec3 best_point = {};
+        Feature best_feature = Feature::Face;
+        uint32_t best_triangle = std::numeric_limits<uint32_t>::max();
+
+        std::array<uint32_t, _bvh_stack_size> stack; // NOLINT(*-pro-type-member-init)
+        uint32_t stack_size = 0;
+        stack[stack_size++] = 0;
+
+        while (stack_size > 0) {
+            const uint32_t node_index = stack[--stack_size];
+            const BVHNode &node = _bvh[node_index];
+
+            if (node.count > 0) {
+                for (uint32_t index = node.offset; index < node.offset + node.count; ++index) {
+                    const Triangle &triangle = _triangle[index];
+                    Feature feature = Feature::Face;
+                    glm::vec3 point = ClosestPointOnTriangle(position, _position[triangle.vertex[0]],
+                                                             _position[triangle.vertex[1]],
+                                                             _position[triangle.vertex[2]], feature);
+                    glm::vec3 delta = position - point;
+                    float distance2 = glm::dot(delta, delta);
+                    if (distance2 < best_distance2) {
+                        best_distance2 = distance2;
+                        best_point = point;
+                        best_feature = feature;
+                        best_triangle = index;
+                    }
+                }
+                continue;
+            }
+
+            const uint32_t left = node_index + 1;
+            const uint32_t right = node.offset;
+            float left_distance2 = BoxDistance2(position, _bvh[left].minBound, _bvh[left].maxBound);
+            float right_distance2 = BoxDistance2(position, _bvh[right].minBound, _bvh[right].maxBound);
+
+            // Push the farther child first so the nearer one is visited first and tightens the bound
+            std::pair<uint32_t, float> near_child = {left, left_distance2};
+            std::pair<uint32_t, float> far_child = {right, right_distance2};
+            if (right_distance2 < left_distance2) {
+                std::swap(near_child, far_child);
+            }
+
+            CHECK(stack_size + 2 <= _bvh_stack_size, "BVH Stack Overflow");
+            if (far_child.second < best_distance2) {
+                stack[stack_size++] = far_child.first;
+            }
+            if (near_child.second < best_distance2) {
+                stack[stack_size++] = near_child.first;
+            }
+        }
+
+        if (best_triangle == std::numeric_limits<uint32_t>::max()) {
+            return std::numeric_limits<float>::max();
+        }
+
+        const Triangle &triangle = _triangle[best_triangle];
+        glm::vec3 pseudo_normal;
+        switch (best_feature) {
+            case Feature::Edge0:
+                pseudo_normal = triangle.edgeNormal[0];
+                break;
+            case Feature::Edge1:
+                pseudo_normal = triangle.edgeNormal[1];
+                break;
+            case Feature::Edge2:
+                pseudo_normal = triangle.edgeNormal[2];
+                break;
+            case Feature::Vertex0:
+                pseudo_normal = _vertex_normal[triangle.vertex[0]];
+                break;
+            case Feature::Vertex1:
+                pseudo_normal = _vertex_normal[triangle.vertex[1]];
+                break;
+            case Feature::Vertex2:
+                pseudo_normal = _vertex_normal[triangle.vertex[2]];
+                break;
+            default:
+                pseudo_normal = triangle.normal;
+                break;
+        }
+
+        const float distance = std::sqrt(best_distance2);
+        return glm::dot(position - best_point, pseudo_normal) < 0 ? -distance : distance;
+    }
+
+    SDFType MeshSDFBaker::GetSDF() const {
+        auto baker = std::make_shared<const MeshSDFBaker>(*this);
+        return [baker](SDFInputType p) { return baker->GetDistance(p); };
+    }
+
+    void MeshSDFBaker::WeldVertices(const CPUMeshData &mesh) {
+        // Pseudo normals need shared topology, vertices with identical position are merged
+        std::map<std::array<float, 3>, uint32_t> position_map;
+        std::vector<uint32_t> remap(mesh.vertex.size());
+
+        for (size_t index = 0; index < mesh.vertex.size(); ++index) {
+            const glm::vec3 &position = mesh.vertex[index].position;
+            auto [it, inserted] = position_map.try_emplace({position.x, position.y, position.z},
+                                                           static_cast<uint32_t>(_position.size()));
+            if (inserted) {
+                _position.push_back(position);
+            }
+            remap[index] = it->second;
+        }
+
+        _triangle.reserve(mesh.index.size() / 3);
+        for (size_t index = 0; index < mesh.index.size(); index += 3) {
+            const std::array<uint32_t, 3> vertex = {remap[mesh.index[index]], remap[mesh.index[index + 1]],
+                                                    remap[mesh.index[index + 2]]};
+
+            glm::vec3 normal = glm::cross(_position[vertex[1]] - _position[vertex[0]],
+                                          _position[vertex[2]] - _position[vertex[0]]);
+            const float area2 = glm::length(normal);
+            if (area2 <= std::numeric_limits<float>::epsilon()) {
+                continue; // Skip degenerated triangle
+            }
+
+            _triangle.push_back({.vertex = vertex, .normal = normal / area2, .edgeNormal = {}});
+        }
+    }
+
+    void MeshSDFBaker::BuildPseudoNormals() {
+        // Edge pseudo normal is the sum of the adjacent face normals
+        std::map<std::pair<uint32_t, uint32_t>, glm::vec3> edge_normal;
+        _vertex_normal.assign(_position.size(), glm::vec3{0});
+
+        for (const auto &triangle: _triangle) {
+            for (uint32_t index = 0; index < 3; ++index) {
+                const uint32_t v0 = triangle.vertex[index];
+                const uint32_t v1 = triangle.vertex[(index + 1) % 3];
+                const uint32_t v2 = triangle.vertex[(index + 2) % 3];
+
+                edge_normal[std::minmax(v0, v1)] += triangle.normal;
+
+                // Vertex pseudo normal is weighted by the incident angle
+                const glm::vec3 e0 = glm::normalize(_position[v1] - _position[v0]);
+                const glm::vec3 e1 = glm::normalize(_position[v2] - _position[v0]);
+                const float angle = std::acos(glm::clamp(glm::dot(e0, e1), -1.0f, 1.0f));
+                _vertex_normal[v0] += angle * triangle.normal;
+            }
+        }
+
+        for (auto &normal: _vertex_normal) {
+            if (glm::dot(normal, normal) > 0) {
+                normal = glm::normalize(normal);
+            }
+        }
+
+        for (auto &triangle: _triangle) {
+            for (uint32_t index = 0; index < 3; ++index) {
+                const glm::vec3 normal =
+                        edge_normal[std::minmax(triangle.vertex[index], triangle.vertex[(index + 1) % 3])];
+                triangle.edgeNormal[index] = glm::dot(normal, normal) > 0 ? glm::normalize(normal) : triangle.normal;
+            }
+        }
+    }
+
+    void MeshSDFBaker::BuildBVH() {
+        if (_triangle.empty()) {
+            return;
+        }
+
+        std::vector<glm::vec3> centroids(_triangle.size());
+        std::vector<uint32_t> order(_triangle.size());
+        for (uint32_t index = 0; index < _triangle.size(); ++index) {
+            const auto &vertex = _triangle[index].vertex;
+            centroids[index] = (_position[vertex[0]] + _position[vertex[1]] + _position[vertex[2]]) / 3.0f;
+            order[index] = index;
+        }
+
+        _bvh.reserve(2 * _triangle.size() / _bvh_leaf_size + 1);
+        BuildBVHNode(0, static_cast<uint32_t>(_triangle.size()), order, centroids);
+
+        // Reorder triangles so each leaf references a contiguous range
+        std::vector<Triangle> triangles(_triangle.size());
+        for (uint32_t index = 0; index < order.size(); ++index) {
+            triangles[index] = _triangle[order[index]];
+        }
+        _triangle = std::move(triangles);
+    }
+
+    uint32_t MeshSDFBaker::BuildBVHNode(const uint32_t begin, const uint32_t end, std::vector<uint32_t> &order,
+                                        const std::vector<glm::vec3> &centroids) {
+        const uint32_t node_index = static_cast<uint32_t>(_bvh.size());
+        _bvh.push_back({.minBound = glm::vec3{std::numeric_limits<float>::max()},
+                        .maxBound = glm::vec3{std::numeric_limits<float>::lowest()},
+                        .offset = begin,
+                        .count = end - begin});
+
+        glm::vec3 min_bound = glm::vec3{std::numeric_limits<float>::max()};
+        glm::vec3 max_bound = glm::vec3{std::numeric_limits<float>::lowest()};
+        glm::vec3 centroid_min = min_bound;
+        glm::vec3 centroid_max = max_bound;
+        for (uint32_t index = begin; index < end; ++index) {
+            for (const uint32_t vertex: _triangle[order[index]].vertex) {
+                min_bound = glm::min(min_bound, _position[vertex]);
+                max_bound = glm::max(max_bound, _position[vertex]);
+            }
+            centroid_min = glm::min(centroid_min, centroids[order[index]]);
+            centroid_max = glm::max(centroid_max, centroids[order[index]]);
+        }
+        _bvh[node_index].minBound = min_bound;
+        _bvh[node_index].maxBound = max_bound;
+
+        if (end - begin <= _bvh_leaf_size) {
+            return node_index;
+        }
+
+        // Median split along the longest centroid axis
+        const glm::vec3 extent = centroid_max - centroid_min;
+        const int axis = extent.x > extent.y ? (extent.x > extent.z ? 0 : 2) : (extent.y > extent.z ? 1 : 2);
+        const uint32_t middle = begin + (end - begin) / 2;
+        std::nth_element(order.begin() + begin, order.begin() + middle, order.begin() + end,
+                         [&](const uint32_t a, const uint32_t b) { return centroids[a][axis] < centroids[b][axis]; });
+
+        BuildBVHNode(begin, middle, order, centroids);
+        const uint32_t right = BuildBVHNode(middle, end, order, centroids);
+
+        _bvh[node_index].offset = right;
+        _bvh[node_index].count = 0;
+        return node_index;
+    }
+
+    glm::vec3 MeshSDFBaker::ClosestPointOnTriangle(const glm::vec3 &p, const glm::vec3 &a, const glm::vec3 &b,
+                                                   const glm::vec3 &c, Feature &feature) {
+        // Real-Time Collision Detection, 5.1.5
+        const glm::vec3 ab = b - a;
+        const glm::vec3 ac = c - a;
+        const glm::vec3 ap = p - a;
+        const float d1 = glm::dot(ab, ap);
+        const float d2 = glm::dot(ac, ap);
+        if (d1 <= 0 && d2 <= 0) {
+            feature = Feature::Vertex0;
+            return a;
+        }
+
+        const glm::vec3 bp = p - b;
+        const float d3 = glm::dot(ab, bp);
+        const float d4 = glm::dot(ac, bp);
+        if (d3 >= 0 && d4 <= d3) {
+            feature = Feature::Vertex1;
+            return b;
+        }
+
+        const float vc = d1 * d4 - d3 * d2;
+        if (vc <= 0 && d1 >= 0 && d3 <= 0) {
+            feature = Feature::Edge0;
+            return a + ab * (d1 / (d1 - d3));
+        }
+
+        const glm::vec3 cp = p - c;
+        const float d5 = glm::dot(ab, cp);
+        const float d6 = glm::dot(ac, cp);
+        if (d6 >= 0 && d5 <= d6) {
+            feature = Feature::Vertex2;
+            return c;
+        }
+
+        const float vb = d5 * d2 - d1 * d6;
+        if (vb <= 0 && d2 >= 0 && d6 <= 0) {
+            feature = Feature::Edge2;
+            return a + ac * (d2 / (d2 - d6));
+        }
+
+        const float va = d3 * d6 - d5 * d4;
+        if (va <= 0 && (d4 - d3) >= 0 && (d5 - d6) >= 0) {
+            feature = Feature::Edge1;
+            return b + (c - b) * ((d4 - d3) / ((d4 - d3) + (d5 - d6)));
+        }
+
+        const float denominator = 1.0f / (va + vb + vc);
+        feature = Feature::Face;
+        return a + ab * (vb * denominator) + ac * (vc * denominator);
+    }
+
+    float MeshSDFBaker::BoxDistance2(const glm::vec3 &p, const glm::vec3 &minBound, const glm::vec3 &maxBound) {
+        const glm::vec3 delta = glm::max(glm::max(minBound - p, p - maxBound), glm::vec3{0});
+        return glm::dot(delta, delta);
+    }
+
+    void MeshSDFBaker::FastSweeping(SDFVolume &volume, std::vector<uint8_t> &frozen) const {
+        const glm::ivec3 size = glm::ivec3(volume.size);
+        const float h = 1.0f / volume.resolution;
+
+        auto neighbour = [&](const glm::ivec3 &index, const int axis, float &magnitude, float &sign) {
+            float axis_min = std::numeric_limits<float>::infinity();
+            for (const int offset: {-1, 1}) {
+                glm::ivec3 neighbour_index = index;
+                neighbour_index[axis] += offset;
+                if (neighbour_index[axis] < 0 || neighbour_index[axis] >= size[axis]) {
+                    continue;
+                }
+                const float value = volume.GetValue(glm::uvec3(neighbour_index));
+                if (std::abs(value) < axis_min) {
+                    axis_min = std::abs(value);
+                    if (axis_min < magnitude) {
+                        magnitude = axis_min;
+                        sign = value < 0 ? -1.0f : 1.0f;
+                    }
+                }
+            }
+            return axis_min;
+        };
+
+        // Godunov upwind update of |grad d| = 1, sign is carried from the closest upwind neighbour
+        auto update = [&](const glm::ivec3 &index) {
+            const size_t index_1d = volume.GetIndex1D(glm::uvec3(index));
+            if (frozen[index_1d]) {
+                return;
+            }
+
+            float closest = std::numeric_limits<float>::infinity();
+            float sign = 1.0f;
+            std::array<float, 3> a = {neighbour(index, 0, closest, sign), neighbour(index, 1, closest, sign),
+                                      neighbour(index, 2, closest, sign)};
+            if (std::isinf(closest)) {
+                return;
+            }
+            std::ranges::sort(a);
+
+            float u = a[0] + h;
+            if (u > a[1]) {
+                u = 0.5f * (a[0] + a[1] + std::sqrt(2.0f * h * h - (a[0] - a[1]) * (a[0] - a[1])));
+                if (u > a[2]) {
+                    const float sum = a[0] + a[1] + a[2];
+                    const float sum2 = a[0] * a[0] + a[1] * a[1] + a[2] * a[2];
+                    u = (sum + std::sqrt(std::max(0.0f, sum * sum - 3.0f * (sum2 - h * h)))) / 3.0f;
+                }
+            }
+
+            if (u < std::abs(volume.value[index_1d])) {
+                volume.value[index_1d] = sign * u;
+            }
+        };
+
+        for (uint32_t iteration = 0; iteration < _fast_sweeping_iteration; ++iteration) {
+            for (int sweep = 0; sweep < 8; ++sweep) {
+                const glm::ivec3 direction = {sweep & 1 ? -1 : 1, sweep & 2 ? -1 : 1, sweep & 4 ? -1 : 1};
+                const glm::ivec3 begin = {direction.x > 0 ? 0 : size.x - 1, direction.y > 0 ? 0 : size.y - 1,
+                                          direction.z > 0 ? 0 : size.z - 1};
+                for (int x = begin.x; x >= 0 && x < size.x; x += direction.x) {
+                    for (int y = begin.y; y >= 0 && y < size.y; y += direction.y) {
+                        for (int z = begin.z; z >= 0 && z < size.z; z += direction.z) {
+                            update({x, y, z});
+                        }
+                    }
+                }
+            }
+        }
+    }
+
+} // namespace Vkxel
@@ -0,0 +1,85 @@
+//
+// Created by jiayi on 10/19/2026.
+//
+
+#ifndef VKXEL_MESH_SDF_H
+#define VKXEL_MESH_SDF_H
+
+#include <array>
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+#include "glm/glm.hpp"
+
+#include "engine/data_type.h"
+#include "sdf_volume.h"
+
+namespace Vkxel {
+
+    // Convert a closed triangle mesh to a signed distance field
+    class MeshSDFBaker {
+    public:
+        explicit MeshSDFBaker(const CPUMeshData &mesh);
+
+        // Exact distance is only computed within narrowBand voxels of the surface when fast sweeping is enabled,
+        // the remaining voxels are filled by solving the eikonal equation from the band
+        bool enableFastSweeping = false;
+        float narrowBand = 3.0f;
+
+        // 0 means use all hardware threads
+        uint32_t threadCount = 0;
+
+        // Bake into a lattice with the same layout as DualContouring, point index / resolution + minBound
+        SDFVolume Bake(const glm::vec3 &minBound, const glm::vec3 &maxBound, float resolution) const;
+        // Bake over the mesh vertex bound padded by paddingVoxels on every side
+        SDFVolume Bake(float resolution, uint32_t paddingVoxels) const;
+
+        // Signed distance using angle weighted pseudo normal, returns max float if no triangle within maxDistance
+        float GetDistance(const glm::vec3 &position,
+                          float maxDistance = std::numeric_limits<float>::max()) const;
+
+        SDFType GetSDF() const;
+
+    private:
+        enum class Feature : uint8_t { Face, Edge0, Edge1, Edge2, Vertex0, Vertex1, Vertex2 };
+
+        struct Triangle {
+            std::array<uint32_t, 3> vertex;
+            glm::vec3 normal;
+            std::array<glm::vec3, 3> edgeNormal;
+        };
+
+        struct BVHNode {
+            glm::vec3 minBound;
+            glm::vec3 maxBound;
+            // Leaf: first triangle index, Inner: right child index (left child is always the next node)
+            uint32_t offset;
+            uint32_t count;
+        };
+
+        void WeldVertices(const CPUMeshData &mesh);
+        void BuildPseudoNormals();
+        void BuildBVH();
+        uint32_t BuildBVHNode(uint32_t begin, uint32_t end, std::vector<uint32_t> &order,
+                              const std::vector<glm::vec3> &centroids);
+
+        static glm::vec3 ClosestPointOnTriangle(const glm::vec3 &p, const glm::vec3 &a, const glm::vec3 &b,
+                                                const glm::vec3 &c, Feature &feature);
+        static float BoxDistance2(const glm::vec3 &p, const glm::vec3 &minBound, const glm::vec3 &maxBound);
+
+        void FastSweeping(SDFVolume &volume, std::vector<uint8_t> &frozen) const;
+
+        std::vector<glm::vec3> _position;
+        std::vector<glm::vec3> _vertex_normal;
+        std::vector<Triangle> _triangle;
+        std::vector<BVHNode> _bvh;
+
+        static constexpr uint32_t _bvh_leaf_size = 4;
+        static constexpr uint32_t _bvh_stack_size = 64;
+        static constexpr uint32_t _fast_sweeping_iteration = 2;
+    };
+
+} // namespace Vkxel
+
+#endif // VKXEL_MESH_SDF_H
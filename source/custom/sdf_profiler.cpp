@@ -0,0 +1,180 @@
+//
+// Created by jiayi on 10/19/2026.
+//
+
+#include <algorithm>
+#include <chrono>
+#include <format>
+#include <ranges>
+#include <string>
+#include <vector>
+
+#include "imgui.h"
+#include "rfl/json.hpp"
+
+#include "engine/file.h"
+#include "sdf_profiler.h"
+#include "util/debug.hpp"
+#include "world/gameobject.hpp"
+
+namespace Vkxel {
+
+    namespace {
+        // Time spent in nested nodes of the current evaluation, used to derive self time
+        thread_local uint64_t sdf_child_nanoseconds = 0;
+
+        class ScopedSample {
+        public:
+            explicit ScopedSample(std::atomic<uint64_t> &total, std::atomic<uint64_t> &self) :
+                _total(total), _self(self), _parent_child_nanoseconds(sdf_child_nanoseconds),
+                _start(std::chrono::steady_clock::now()) {
+                sdf_child_nanoseconds = 0;
+            }
+
+            ~ScopedSample() {
+                const uint64_t elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                                                 std::chrono::steady_clock::now() - _start)
+                                                 .count();
+                _total.fetch_add(elapsed, std::memory_order_relaxed);
+                _self.fetch_add(elapsed - std::min(elapsed, sdf_child_nanoseconds), std::memory_order_relaxed);
+                sdf_child_nanoseconds = _parent_child_nanoseconds + elapsed;
+            }
+
+        private:
+            std::atomic<uint64_t> &_total;
+            std::atomic<uint64_t> &_self;
+            uint64_t _parent_child_nanoseconds;
+            std::chrono::steady_clock::time_point _start;
+        };
+    } // namespace
+
+    SDFProfiler &SDFProfiler::Instance() {
+        static SDFProfiler instance;
+        return instance;
+    }
+
+    bool SDFProfiler::IsEnabled() const { return _enabled.load(std::memory_order_relaxed); }
+
+    void SDFProfiler::SetEnabled(const bool enabled) { _enabled.store(enabled, std::memory_order_relaxed); }
+
+    void SDFProfiler::Reset() {
+        // Counters are referenced by wrapped closures, clear the value instead of the entry
+        std::scoped_lock lock(_mutex);
+        for (const auto &counter: _counter | std::views::values) {
+            counter->evaluationCount = 0;
+            counter->totalNanoseconds = 0;
+            counter->selfNanoseconds = 0;
+        }
+    }
+
+    SDFType SDFProfiler::Wrap(const SDFSurface &node, SDFType sdf) {
+        if (!IsEnabled() || !sdf) {
+            return sdf;
+        }
+
+        Counter &counter = GetCounter(node);
+        return [&counter, sdf = std::move(sdf)](SDFInputType p) {
+            counter.evaluationCount.fetch_add(1, std::memory_order_relaxed);
+            ScopedSample sample(counter.totalNanoseconds, counter.selfNanoseconds);
+            return sdf(p);
+        };
+    }
+
+    SDFBatchType SDFProfiler::Wrap(const SDFSurface &node, SDFBatchType sdf) {
+        if (!IsEnabled() || !sdf) {
+            return sdf;
+        }
+
+        Counter &counter = GetCounter(node);
+        return [&counter, sdf = std::move(sdf)](SDFBatchInputType p, SDFBatchOutputType value) {
+            counter.evaluationCount.fetch_add(p.size(), std::memory_order_relaxed);
+            ScopedSample sample(counter.totalNanoseconds, counter.selfNanoseconds);
+            sdf(p, value);
+        };
+    }
+
+    std::vector<SDFProfileEntry> SDFProfiler::GetReport() const {
+        std::vector<SDFProfileEntry> report;
+        {
+            std::scoped_lock lock(_mutex);
+            report.reserve(_counter.size());
+            for (const auto &[id, counter]: _counter) {
+                const uint64_t total_nanoseconds = counter->totalNanoseconds.load(std::memory_order_relaxed);
+                const uint64_t self_nanoseconds = counter->selfNanoseconds.load(std::memory_order_relaxed);
+                report.push_back({.id = id,
+                                  .name = counter->name,
+                                  .evaluationCount = counter->evaluationCount.load(std::memory_order_relaxed),
+                                  .totalMilliseconds = static_cast<double>(total_nanoseconds) * 1e-6,
+                                  .selfMilliseconds = static_cast<double>(self_nanoseconds) * 1e-6});
+            }
+        }
+
+        std::ranges::sort(report, std::ranges::greater{}, &SDFProfileEntry::selfMilliseconds);
+        return report;
+    }
+
+    std::string SDFProfiler::GetReportJson() const { return rfl::json::write(GetReport(), rfl::json::pretty); }
+
+    void SDFProfiler::DumpReportJson(const std::string_view filePath) const {
+        File::WriteTextFile(filePath, GetReportJson());
+        Debug::LogInfo("SDF Profile Dumped To {}", filePath);
+    }
+
+    void SDFProfiler::OnGUI() {
+        bool enabled = IsEnabled();
+        if (ImGui::Checkbox("Profile SDF", &enabled)) {
+            SetEnabled(enabled);
+        }
+        ImGui::SameLine();
+        if (ImGui::SmallButton("Reset")) {
+            Reset();
+        }
+        ImGui::SameLine();
+        if (ImGui::SmallButton("Dump JSON")) {
+            DumpReportJson(_dump_file_path);
+        }
+
+        const auto report = GetReport();
+        if (report.empty()) {
+            return;
+        }
+
+        if (ImGui::BeginTable("SDF Profile", 5, ImGuiTableFlags_Borders | ImGuiTableFlags_RowBg)) {
+            ImGui::TableSetupColumn("Node");
+            ImGui::TableSetupColumn("Count");
+            ImGui::TableSetupColumn("Self (ms)");
+            ImGui::TableSetupColumn("Total (ms)");
+            ImGui::TableSetupColumn("Self (ns/eval)");
+            ImGui::TableHeadersRow();
+
+            for (const auto &entry: report) {
+                ImGui::TableNextRow();
+                ImGui::TableNextColumn();
+                // Node names are user object names, so nothing is passed as a format string
+                ImGui::TextUnformatted(std::format("{0} ({1})", entry.name, entry.id).c_str());
+                ImGui::TableNextColumn();
+                ImGui::TextUnformatted(std::format("{0}", entry.evaluationCount).c_str());
+                ImGui::TableNextColumn();
+                ImGui::TextUnformatted(std::format("{0:.3f}", entry.selfMilliseconds).c_str());
+                ImGui::TableNextColumn();
+                ImGui::TextUnformatted(std::format("{0:.3f}", entry.totalMilliseconds).c_str());
+                ImGui::TableNextColumn();
+                const double self_per_evaluation =
+                        entry.evaluationCount > 0 ? entry.selfMilliseconds * 1e6 / entry.evaluationCount : 0.0;
+                ImGui::TextUnformatted(std::format("{0:.1f}", self_per_evaluation).c_str());
+            }
+            ImGui::EndTable();
+        }
+    }
+
+    SDFProfiler::Counter &SDFProfiler::GetCounter(const SDFSurface &node) {
+        std::scoped_lock lock(_mutex);
+        auto &counter = _counter[node.id];
+        if (!counter) {
+            counter = std::make_unique<Counter>();
+            counter->name = node.gameObject.name;
+        }
+        return *counter;
+    }
+
+} // namespace Vkxel
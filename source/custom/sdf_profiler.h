@@ -0,0 +1,73 @@
+//
+// Created by jiayi on 10/19/2026.
+//
+
+#ifndef VKXEL_SDF_PROFILER_H
+#define VKXEL_SDF_PROFILER_H
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+#include "engine/data_type.h"
+#include "sdf_surface.h"
+
+namespace Vkxel {
+
+    struct SDFProfileEntry {
+        IdType id = 0;
+        std::string name;
+        uint64_t evaluationCount = 0;
+        // Including children
+        double totalMilliseconds = 0;
+        // Excluding children
+        double selfMilliseconds = 0;
+    };
+
+    // Opt-in per node evaluation counter, SDFSurface only wraps its closure while the profiler is enabled,
+    // so a disabled profiler adds no cost to the evaluation
+    class SDFProfiler {
+    public:
+        static SDFProfiler &Instance();
+
+        bool IsEnabled() const;
+        void SetEnabled(bool enabled);
+        void Reset();
+
+        SDFType Wrap(const SDFSurface &node, SDFType sdf);
+        SDFBatchType Wrap(const SDFSurface &node, SDFBatchType sdf);
+
+        // Sorted by self time in descending order
+        std::vector<SDFProfileEntry> GetReport() const;
+        std::string GetReportJson() const;
+        void DumpReportJson(std::string_view filePath) const;
+
+        void OnGUI();
+
+    private:
+        SDFProfiler() = default;
+
+        struct Counter {
+            std::string name;
+            std::atomic<uint64_t> evaluationCount = 0;
+            std::atomic<uint64_t> totalNanoseconds = 0;
+            std::atomic<uint64_t> selfNanoseconds = 0;
+        };
+
+        Counter &GetCounter(const SDFSurface &node);
+
+        std::atomic<bool> _enabled = false;
+        mutable std::mutex _mutex;
+        std::unordered_map<IdType, std::unique_ptr<Counter>> _counter;
+
+        std::string _dump_file_path = "./sdf_profile.json";
+    };
+
+} // namespace Vkxel
+
+#endif // VKXEL_SDF_PROFILER_H
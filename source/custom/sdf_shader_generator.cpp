@@ -0,0 +1,232 @@
+//
+// Created by jiayi on 10/19/2026.
+//
+
+#include <algorithm>
+#include <format>
+#include <limits>
+#include <string>
+#include <vector>
+
+#include "glm/glm.hpp"
+#include "glm/gtc/constants.hpp"
+
+#include "sdf_shader_generator.h"
+#include "util/debug.hpp"
+#include "util/hash.hpp"
+#include "world/gameobject.hpp"
+#include "world/transform.h"
+
+namespace Vkxel {
+
+    SDFShaderGenerator::SDFShaderGenerator(const SDFSurface &root) {
+        GenerateNode(root, glm::mat4{1.0f}, 1.0f);
+
+        // Names and parameter values stay out of the source, so renaming or tweaking a node keeps the hash
+        _source = std::format("// Generated by SDFShaderGenerator\n"
+                              "import sdf;\n"
+                              "\n"
+                              "#include \"dual_contouring.slang\"\n"
+                              "\n"
+                              "struct SDFNodeData {{\n"
+                              "    float4x4 transform;\n"
+                              "    float scale;\n"
+                              "    float4 parameter0;\n"
+                              "    float4 parameter1;\n"
+                              "}};\n"
+                              "\n"
+                              "[[vk::binding({0})]] StructuredBuffer<SDFNodeData> sdfNodes;\n"
+                              "\n"
+                              "float3 sdfNodePosition(uint node, float3 p) {{\n"
+                              "    return mul(sdfNodes[node].transform, float4(p, 1)).xyz;\n"
+                              "}}\n"
+                              "\n"
+                              "float sdf(float3 position) {{\n"
+                              "    return sdfNode0(position);\n"
+                              "}}\n",
+                              NodeBufferBinding);
+
+        for (const auto &node_source: _node_source) {
+            _source += "\n";
+            _source += node_source;
+        }
+
+        _hash = Hash::String(_source);
+        _name = std::format("sdf_generated_{0:016x}", _hash);
+    }
+
+    uint64_t SDFShaderGenerator::GetHash() const { return _hash; }
+
+    const std::string &SDFShaderGenerator::GetName() const { return _name; }
+
+    const std::string &SDFShaderGenerator::GetSource() const { return _source; }
+
+    const std::vector<SDFShaderGenerator::NodeData> &SDFShaderGenerator::GetNodeData() const { return _node_data; }
+
+    uint32_t SDFShaderGenerator::GenerateNode(const SDFSurface &node, const glm::mat4 &transform, const float scale) {
+        const uint32_t node_index = static_cast<uint32_t>(_node_data.size());
+        _node_data.push_back({.transform = transform, .scale = scale});
+        SetNodeParameter(node, _node_data.back());
+        _node_source.emplace_back();
+
+        // Same transform and scale as SDFSurface::GetChildSDF, relative to the parent node
+        std::vector<uint32_t> children;
+        if (node.surfaceType == SurfaceType::CSG || node.surfaceType == SurfaceType::Repetition) {
+            for (const auto &child_wrapper: node.gameObject.transform.GetChildren()) {
+                Transform &child = child_wrapper;
+                if (auto child_sdf_surface = child.gameObject.GetComponent<SDFSurface>()) {
+                    float child_minimum_scale = std::min({child.scale.x, child.scale.y, child.scale.z});
+                    children.push_back(GenerateNode(child_sdf_surface.value(), child.GetRelativeToLocalMatrix(),
+                                                    child_minimum_scale));
+                }
+            }
+        }
+
+        std::string body;
+        switch (node.surfaceType) {
+            case SurfaceType::Primitive:
+                body = GeneratePrimitive(node);
+                break;
+            case SurfaceType::CSG:
+                body = GenerateCSG(node, node_index, children);
+                break;
+            case SurfaceType::Repetition:
+                body = GenerateRepetition(node, node_index, children);
+                break;
+            case SurfaceType::Custom:
+                Debug::LogWarning("Custom SDF \"{}\" Can Not Be Generated On GPU", node.gameObject.name);
+                body = "    return 3.402823466e+38;\n";
+                break;
+            default:
+                body = "    return 3.402823466e+38;\n";
+                break;
+        }
+
+        _node_source[node_index] = std::format("float sdfNode{0}(float3 p) {{\n{1}}}\n", node_index, body);
+        return node_index;
+    }
+
+    std::string SDFShaderGenerator::GenerateChildCall(const uint32_t child, const std::string_view position) const {
+        return std::format("sdfNodes[{0}].scale * sdfNode{0}(sdfNodePosition({0}, {1}))", child, position);
+    }
+
+    std::string SDFShaderGenerator::GeneratePrimitive(const SDFSurface &node) const {
+        switch (node.primitiveType) {
+            case PrimitiveType::Sphere:
+                return "    return sdfSphere(p);\n";
+            case PrimitiveType::Box:
+                return "    return sdfBox(p);\n";
+            case PrimitiveType::Capsule:
+                return "    return sdfCapsule(p);\n";
+            default:
+                return "    return 3.402823466e+38;\n";
+        }
+    }
+
+    std::string SDFShaderGenerator::GenerateCSG(const SDFSurface &node, const uint32_t nodeIndex,
+                                                const std::vector<uint32_t> &children) const {
+        if (node.csgType == CSGType::None || children.empty()) {
+            return node.csgType == CSGType::Intersect ? "    return -3.402823466e+38;\n"
+                                                      : "    return 3.402823466e+38;\n";
+        }
+
+        // Fold children in order like the CPU CSG, the first child initializes the value,
+        // the smooth factor is read at runtime so toggling smoothing does not change the source either
+        std::string body = std::format("    float k = sdfNodes[{0}].parameter0.x;\n"
+                                       "    float value = {1};\n",
+                                       nodeIndex, GenerateChildCall(children[0], "p"));
+        for (size_t index = 1; index < children.size(); ++index) {
+            body += std::format("    float child{0} = {1};\n", index, GenerateChildCall(children[index], "p"));
+            switch (node.csgType) {
+                case CSGType::Unionize:
+                    body += std::format("    value = k > 0 ? csgSmoothUnion(value, child{0}, k) "
+                                        ": csgUnion(value, child{0});\n",
+                                        index);
+                    break;
+                case CSGType::Intersect:
+                    body += std::format("    value = k > 0 ? csgSmoothIntersection(value, child{0}, k) "
+                                        ": csgIntersection(value, child{0});\n",
+                                        index);
+                    break;
+                case CSGType::Subtract:
+                    body += std::format("    value = k > 0 ? csgSmoothSubtraction(child{0}, value, k) "
+                                        ": csgSubtraction(child{0}, value);\n",
+                                        index);
+                    break;
+                default:
+                    break;
+            }
+        }
+        body += "    return value;\n";
+        return body;
+    }
+
+    std::string SDFShaderGenerator::GenerateRepetition(const SDFSurface &node, const uint32_t nodeIndex,
+                                                       const std::vector<uint32_t> &children) const {
+        // Same folds as SDFSurface::GetRepetitionFold
+        std::string body = std::format("    float4 parameter0 = sdfNodes[{0}].parameter0;\n"
+                                       "    float4 parameter1 = sdfNodes[{0}].parameter1;\n",
+                                       nodeIndex);
+        switch (node.repetitionType) {
+            case RepetitionType::Grid:
+                body += "    float3 q = p - parameter0.xyz * round(p / parameter0.xyz);\n";
+                break;
+            case RepetitionType::FiniteGrid:
+                body += "    float3 q = p - parameter0.xyz * clamp(round(p / parameter0.xyz), -parameter1.xyz, "
+                        "parameter1.xyz);\n";
+                break;
+            case RepetitionType::Mirror:
+                body += "    float3 q = lerp(p, abs(p), parameter0.xyz);\n";
+                break;
+            case RepetitionType::Polar:
+                body += "    float sector = parameter0.x;\n"
+                        "    float angle = atan2(p.z, p.x);\n"
+                        "    angle -= sector * round(angle / sector);\n"
+                        "    float radius = length(p.xz);\n"
+                        "    float3 q = float3(radius * cos(angle), p.y, radius * sin(angle));\n";
+                break;
+            default:
+                return "    return 3.402823466e+38;\n";
+        }
+
+        body += "    float value = 3.402823466e+38;\n";
+        for (const uint32_t child: children) {
+            body += std::format("    value = min(value, {0});\n", GenerateChildCall(child, "q"));
+        }
+        body += "    return value;\n";
+        return body;
+    }
+
+    void SDFShaderGenerator::SetNodeParameter(const SDFSurface &node, NodeData &data) {
+        // Same values as SDFTape::CompileFold and the SDFTape Combine parameter
+        if (node.surfaceType == SurfaceType::CSG) {
+            data.parameter0 = glm::vec4{node.csgSmoothFactor, 0, 0, 0};
+            return;
+        }
+        if (node.surfaceType != SurfaceType::Repetition) {
+            return;
+        }
+
+        const glm::vec3 spacing = glm::max(node.repetitionSpacing, glm::vec3{std::numeric_limits<float>::epsilon()});
+        switch (node.repetitionType) {
+            case RepetitionType::Grid:
+                data.parameter0 = glm::vec4{spacing, 0};
+                break;
+            case RepetitionType::FiniteGrid:
+                data.parameter0 = glm::vec4{spacing, 0};
+                data.parameter1 = glm::vec4{glm::vec3(glm::max(node.repetitionLimit, glm::ivec3{0})), 0};
+                break;
+            case RepetitionType::Mirror:
+                data.parameter0 = glm::vec4{glm::vec3(glm::notEqual(node.repetitionMirrorAxis, glm::ivec3{0})), 0};
+                break;
+            case RepetitionType::Polar:
+                data.parameter0 =
+                        glm::vec4{glm::two_pi<float>() / static_cast<float>(std::max(node.repetitionPolarCount, 1)),
+                                  0, 0, 0};
+                break;
+            default:
+                break;
+        }
+    }
+
+} // namespace Vkxel
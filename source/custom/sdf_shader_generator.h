@@ -0,0 +1,71 @@
+//
+// Created by jiayi on 10/19/2026.
+//
+
+#ifndef VKXEL_SDF_SHADER_GENERATOR_H
+#define VKXEL_SDF_SHADER_GENERATOR_H
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "glm/glm.hpp"
+
+#include "sdf_surface.h"
+
+namespace Vkxel {
+
+    // Translate an SDFSurface hierarchy into a Slang module implementing float sdf(float3 position) for the
+    // dual contouring kernels, node transforms and parameters live in a storage buffer so only structural edits
+    // need a recompile
+    class SDFShaderGenerator {
+    public:
+        // Matches SDFNodeData in the generated shader and shader/sdf_tape.slang
+        struct NodeData {
+            glm::mat4 transform;
+            float scale;
+            // Same layout as the SDFTape Combine and Fold parameters
+            // CSG: x is smooth factor
+            // Grid, FiniteGrid: xyz is spacing, Mirror: xyz is 1 for mirrored axis, Polar: x is sector angle
+            glm::vec4 parameter0;
+            // FiniteGrid: xyz is limit
+            glm::vec4 parameter1;
+        };
+
+        static constexpr uint32_t NodeBufferBinding = 6;
+
+        explicit SDFShaderGenerator(const SDFSurface &root);
+
+        // Hash of the generated source, only changes with the tree structure and node types
+        uint64_t GetHash() const;
+        // Unique shader name for ShaderLoader
+        const std::string &GetName() const;
+        const std::string &GetSource() const;
+
+        // Node transforms and parameters in generation order, node 0 is the root
+        const std::vector<NodeData> &GetNodeData() const;
+
+    private:
+        uint32_t GenerateNode(const SDFSurface &node, const glm::mat4 &transform, float scale);
+
+        std::string GenerateChildCall(uint32_t child, std::string_view position) const;
+        std::string GeneratePrimitive(const SDFSurface &node) const;
+        std::string GenerateCSG(const SDFSurface &node, uint32_t nodeIndex,
+                                const std::vector<uint32_t> &children) const;
+        std::string GenerateRepetition(const SDFSurface &node, uint32_t nodeIndex,
+                                       const std::vector<uint32_t> &children) const;
+
+        static void SetNodeParameter(const SDFSurface &node, NodeData &data);
+
+        std::vector<NodeData> _node_data;
+        std::vector<std::string> _node_source;
+
+        uint64_t _hash = 0;
+        std::string _name;
+        std::string _source;
+    };
+
+} // namespace Vkxel
+
+#endif // VKXEL_SDF_SHADER_GENERATOR_H
@@ -2,25 +2,69 @@
 // Created by jiayi on 2/9/2025.
 //
 
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+#include "glm/gtc/constants.hpp"
+
+#include "sdf_profiler.h"
 #include "sdf_surface.h"
 
+#include "util/hash.hpp"
 #include "world/gameobject.hpp"
 namespace Vkxel {
     SDFType SDFSurface::GetSDF() const {
+        SDFType sdf;
         switch (surfaceType) {
             case SurfaceType::Primitive:
-                return GetPrimitive();
+                sdf = GetPrimitive();
+                break;
             case SurfaceType::Custom:
-                return customSDF;
+                sdf = customSDF;
+                break;
             case SurfaceType::CSG:
-                return GetCSG();
+                sdf = GetCSG();
+                break;
+            case SurfaceType::Repetition:
+                sdf = GetRepetition();
+                break;
             default:
-                return NoneSDF;
+                sdf = NoneSDF;
+                break;
         }
+        return SDFProfiler::Instance().Wrap(*this, std::move(sdf));
     }
 
     SDFOutputType SDFSurface::GetSDFValue(SDFInputType p) const { return GetSDF()(p); }
 
+    SDFBatchType SDFSurface::GetBatchSDF() const {
+        SDFBatchType sdf;
+        switch (surfaceType) {
+            case SurfaceType::Custom:
+                sdf = customBatchSDF ? customBatchSDF : ToBatchSDF(customSDF);
+                break;
+            case SurfaceType::CSG:
+                sdf = GetCSGBatch();
+                break;
+            case SurfaceType::Repetition:
+                sdf = GetRepetitionBatch();
+                break;
+            default:
+                // Scalar SDF is already profiled
+                return ToBatchSDF(GetSDF());
+        }
+        return SDFProfiler::Instance().Wrap(*this, std::move(sdf));
+    }
+
+    SDFBatchType SDFSurface::ToBatchSDF(SDFType sdf) {
+        return [sdf = std::move(sdf)](SDFBatchInputType p, SDFBatchOutputType value) {
+            for (size_t index = 0; index < p.size(); ++index) {
+                value[index] = sdf(p[index]);
+            }
+        };
+    }
+
     SDFType SDFSurface::GetPrimitive() const {
         switch (primitiveType) {
             case PrimitiveType::Sphere:
@@ -47,6 +91,182 @@ namespace Vkxel {
         }
     }
 
+    SDFBatchType SDFSurface::GetCSGBatch() const {
+        if (csgType == CSGType::None) {
+            return ToBatchSDF(NoneSDF);
+        }
+
+        const auto child_sdf = GetChildBatchSDF();
+        const CSGType csg_type = csgType;
+        const float k = csgSmoothFactor;
+
+        return [=](SDFBatchInputType p, SDFBatchOutputType value) {
+            std::fill(value.begin(), value.end(), GetCSGEmptyValue(csg_type));
+
+            std::vector<SDFOutputType> child_value(p.size());
+            for (size_t child = 0; child < child_sdf.size(); ++child) {
+                child_sdf[child](p, child_value);
+                CombineCSG(csg_type, k, child, child_value, value);
+            }
+        };
+    }
+
+    SDFOutputType SDFSurface::GetCSGEmptyValue(const CSGType type) {
+        return type == CSGType::Intersect ? std::numeric_limits<SDFOutputType>::lowest()
+                                          : std::numeric_limits<SDFOutputType>::max();
+    }
+
+    void SDFSurface::CombineCSG(const CSGType type, const float smoothFactor, const size_t childIndex,
+                                std::span<const SDFOutputType> childValue, SDFBatchOutputType value) {
+        const float k = smoothFactor;
+
+        if (childIndex == 0) {
+            std::fill(value.begin(), value.end(), GetCSGEmptyValue(type));
+            if (type == CSGType::Subtract) {
+                std::ranges::copy(childValue, value.begin());
+                return;
+            }
+        }
+
+        // Same operators as the scalar CSG
+        for (size_t index = 0; index < value.size(); ++index) {
+            const float sdf_value = childValue[index];
+            float &result = value[index];
+
+            switch (type) {
+                case CSGType::Unionize:
+                    if (k <= 0.0f) {
+                        result = std::min(result, sdf_value);
+                    } else {
+                        float h = glm::clamp(0.5f + 0.5f * (sdf_value - result) / k, 0.0f, 1.0f);
+                        result = glm::mix(sdf_value, result, h) - k * h * (1.0f - h);
+                    }
+                    break;
+                case CSGType::Intersect:
+                    if (k <= 0.0f) {
+                        result = std::max(result, sdf_value);
+                    } else {
+                        float h = glm::clamp(0.5f - 0.5f * (sdf_value - result) / k, 0.0f, 1.0f);
+                        result = glm::mix(sdf_value, result, h) + k * h * (1.0f - h);
+                    }
+                    break;
+                case CSGType::Subtract:
+                    if (k <= 0.0f) {
+                        result = std::max(result, -sdf_value);
+                    } else {
+                        float h = glm::clamp(0.5f - 0.5f * (result + sdf_value) / k, 0.0f, 1.0f);
+                        result = glm::mix(result, -sdf_value, h) + k * h * (1.0f - h);
+                    }
+                    break;
+                default:
+                    break;
+            }
+        }
+    }
+
+    uint64_t SDFSurface::GetVersion() const { return _version; }
+
+    void SDFSurface::MarkDirty() { ++_version; }
+
+    uint64_t SDFSurface::GetSignature() const {
+        // Custom SDF closures can not be compared, their owner must call MarkDirty when they change
+        uint64_t hash = Hash::Value(_version);
+        hash = Hash::Value(surfaceType, hash);
+        hash = Hash::Value(primitiveType, hash);
+        hash = Hash::Value(csgType, hash);
+        hash = Hash::Value(csgSmoothFactor, hash);
+        hash = Hash::Value(repetitionType, hash);
+        hash = Hash::Value(repetitionSpacing, hash);
+        hash = Hash::Value(repetitionLimit, hash);
+        hash = Hash::Value(repetitionMirrorAxis, hash);
+        hash = Hash::Value(repetitionPolarCount, hash);
+        hash = Hash::Value(static_cast<bool>(customBatchSDF), hash);
+        return hash;
+    }
+
+    uint64_t SDFSurface::GetSubtreeSignature() const {
+        uint64_t hash = GetSignature();
+        for (const auto &child_wrapper: gameObject.transform.GetChildren()) {
+            Transform &child = child_wrapper;
+            if (auto child_sdf_surface = child.gameObject.GetComponent<SDFSurface>()) {
+                hash = Hash::Value(child.GetRelativeToLocalMatrix(), hash);
+                hash = Hash::Value(child.scale, hash);
+                hash = Hash::Value(child_sdf_surface.value().get().GetSubtreeSignature(), hash);
+            }
+        }
+        return hash;
+    }
+
+    SDFType SDFSurface::GetRepetition() const {
+        const auto fold = GetRepetitionFold();
+        if (!fold) {
+            return NoneSDF;
+        }
+
+        // Children are unionized inside the folded cell
+        const auto child_sdf = GetChildSDF();
+        return [=](SDFInputType p) {
+            const glm::vec3 q = fold(p);
+            SDFOutputType value = std::numeric_limits<SDFOutputType>::max();
+            for (const auto &sdf: child_sdf) {
+                value = std::min(value, sdf(q));
+            }
+            return value;
+        };
+    }
+
+    SDFBatchType SDFSurface::GetRepetitionBatch() const {
+        const auto fold = GetRepetitionFold();
+        if (!fold) {
+            return ToBatchSDF(NoneSDF);
+        }
+
+        const auto child_sdf = GetChildBatchSDF();
+        return [=](SDFBatchInputType p, SDFBatchOutputType value) {
+            std::vector<glm::vec3> q(p.size());
+            std::ranges::transform(p, q.begin(), fold);
+
+            std::fill(value.begin(), value.end(), std::numeric_limits<SDFOutputType>::max());
+            std::vector<SDFOutputType> child_value(p.size());
+            for (const auto &sdf: child_sdf) {
+                sdf(q, child_value);
+                for (size_t index = 0; index < p.size(); ++index) {
+                    value[index] = std::min(value[index], child_value[index]);
+                }
+            }
+        };
+    }
+
+    std::function<glm::vec3(const glm::vec3 &)> SDFSurface::GetRepetitionFold() const {
+        const glm::vec3 spacing = glm::max(repetitionSpacing, glm::vec3{std::numeric_limits<float>::epsilon()});
+
+        switch (repetitionType) {
+            case RepetitionType::Grid:
+                return [=](const glm::vec3 &p) { return p - spacing * glm::round(p / spacing); };
+            case RepetitionType::FiniteGrid: {
+                const glm::vec3 limit = glm::vec3(glm::max(repetitionLimit, glm::ivec3{0}));
+                return [=](const glm::vec3 &p) {
+                    return p - spacing * glm::clamp(glm::round(p / spacing), -limit, limit);
+                };
+            }
+            case RepetitionType::Mirror: {
+                const glm::bvec3 axis = glm::notEqual(repetitionMirrorAxis, glm::ivec3{0});
+                return [=](const glm::vec3 &p) { return glm::mix(p, glm::abs(p), axis); };
+            }
+            case RepetitionType::Polar: {
+                const float sector = glm::two_pi<float>() / static_cast<float>(std::max(repetitionPolarCount, 1));
+                return [=](const glm::vec3 &p) {
+                    const float angle = std::atan2(p.z, p.x);
+                    const float folded_angle = angle - sector * std::round(angle / sector);
+                    const float radius = glm::length(glm::vec2{p.x, p.z});
+                    return glm::vec3{radius * std::cos(folded_angle), p.y, radius * std::sin(folded_angle)};
+                };
+            }
+            default:
+                return {};
+        }
+    }
+
     SDFType SDFSurface::Unionize() const {
         const auto child_sdf = GetChildSDF();
 
@@ -152,6 +372,29 @@ namespace Vkxel {
         return child_sdf;
     }
 
+    std::vector<SDFBatchType> SDFSurface::GetChildBatchSDF() const {
+        std::vector<SDFBatchType> child_sdf;
+        for (const auto &child_wrapper: gameObject.transform.GetChildren()) {
+            Transform &child = child_wrapper;
+            if (auto child_sdf_surface = child.gameObject.GetComponent<SDFSurface>()) {
+                glm::mat4 child_transform = child.GetRelativeToLocalMatrix();
+                float child_minimum_scale = std::min({child.scale.x, child.scale.y, child.scale.z});
+                SDFBatchType sdf = child_sdf_surface.value().get().GetBatchSDF();
+                child_sdf.emplace_back([=](SDFBatchInputType p, SDFBatchOutputType value) {
+                    std::vector<glm::vec3> child_p(p.size());
+                    for (size_t index = 0; index < p.size(); ++index) {
+                        child_p[index] = child_transform * glm::vec4{p[index], 1.0f};
+                    }
+                    sdf(child_p, value);
+                    for (auto &v: value) {
+                        v *= child_minimum_scale;
+                    }
+                });
+            }
+        }
+        return child_sdf;
+    }
+
     const SDFType SDFSurface::SphereSDF = [](SDFInputType p) { return glm::length(p) - 1; };
 
     const SDFType SDFSurface::BoxSDF = [](SDFInputType p) {
@@ -5,7 +5,9 @@
 #ifndef VKXEL_SDF_SURFACE_H
 #define VKXEL_SDF_SURFACE_H
 
+#include <cstdint>
 #include <functional>
+#include <span>
 
 #include "glm/glm.hpp"
 #include "world/component.h"
@@ -16,11 +18,17 @@ namespace Vkxel {
     using SDFOutputType = float;
     using SDFType = std::function<SDFOutputType(SDFInputType)>;
 
+    // Evaluate many points per call so expensive SDFs can amortize overhead and vectorize across points
+    using SDFBatchInputType = std::span<const glm::vec3>;
+    using SDFBatchOutputType = std::span<SDFOutputType>;
+    using SDFBatchType = std::function<void(SDFBatchInputType, SDFBatchOutputType)>;
+
     enum class SurfaceType {
         None,
         Primitive,
         Custom,
         CSG,
+        Repetition,
     };
 
     enum class PrimitiveType {
@@ -37,6 +45,16 @@ namespace Vkxel {
         Subtract,
     };
 
+    // Fold the sample point into a single cell, children are evaluated once regardless of the copy count,
+    // children should stay inside a cell or the folded distance is no longer exact
+    enum class RepetitionType {
+        None,
+        Grid,
+        FiniteGrid,
+        Mirror,
+        Polar,
+    };
+
     class SDFSurface final : public Component {
     public:
         using Component::Component;
@@ -48,14 +66,52 @@ namespace Vkxel {
         CSGType csgType = CSGType::None;
         float csgSmoothFactor = 0.0f;
 
+        RepetitionType repetitionType = RepetitionType::None;
+        // Grid, FiniteGrid: Cell size
+        glm::vec3 repetitionSpacing = glm::vec3{2.0f};
+        // FiniteGrid: Copies from -repetitionLimit to repetitionLimit on each axis
+        glm::ivec3 repetitionLimit = glm::ivec3{1};
+        // Mirror: Non-zero axis is mirrored across its local plane
+        glm::ivec3 repetitionMirrorAxis = {1, 0, 0};
+        // Polar: Copies around local y axis
+        int repetitionPolarCount = 6;
+
         SDFType customSDF;
+        // Optional batched version of customSDF, must return the same value as customSDF
+        SDFBatchType customBatchSDF;
 
         SDFType GetSDF() const;
         SDFOutputType GetSDFValue(SDFInputType p) const;
 
+        SDFBatchType GetBatchSDF() const;
+
+        // Wrap a scalar SDF as a batch SDF
+        static SDFBatchType ToBatchSDF(SDFType sdf);
+
+        // Fold one child's values into value, childIndex 0 initializes value
+        static void CombineCSG(CSGType type, float smoothFactor, size_t childIndex,
+                               std::span<const SDFOutputType> childValue, SDFBatchOutputType value);
+        static SDFOutputType GetCSGEmptyValue(CSGType type);
+
+        // Bumped by MarkDirty, needed when state the signature can not see changes, e.g. customSDF or a sculpt brush
+        uint64_t GetVersion() const;
+        void MarkDirty();
+
+        // Hash of this node's parameters and version, excluding children
+        uint64_t GetSignature() const;
+        // Hash of this node and all SDF descendants including their transforms
+        uint64_t GetSubtreeSignature() const;
+
     private:
         SDFType GetPrimitive() const;
         SDFType GetCSG() const;
+        SDFBatchType GetCSGBatch() const;
+        SDFType GetRepetition() const;
+        SDFBatchType GetRepetitionBatch() const;
+
+        std::function<glm::vec3(const glm::vec3 &)> GetRepetitionFold() const;
+
+        uint64_t _version = 0;
 
         // CSGs
         SDFType Unionize() const;
@@ -63,6 +119,7 @@ namespace Vkxel {
         SDFType Subtract() const;
 
         std::vector<SDFType> GetChildSDF() const;
+        std::vector<SDFBatchType> GetChildBatchSDF() const;
 
         // Primitives
         const static SDFType SphereSDF;
@@ -76,6 +133,11 @@ namespace Vkxel {
         REGISTER_DATA(primitiveType)
         REGISTER_DATA(csgType)
         REGISTER_DATA(csgSmoothFactor)
+        REGISTER_DATA(repetitionType)
+        REGISTER_DATA(repetitionSpacing)
+        REGISTER_DATA(repetitionLimit)
+        REGISTER_DATA(repetitionMirrorAxis)
+        REGISTER_DATA(repetitionPolarCount)
         REGISTER_END()
     };
 } // namespace Vkxel
@@ -0,0 +1,134 @@
+//
+// Created by jiayi on 10/19/2026.
+//
+
+#include <algorithm>
+#include <limits>
+#include <vector>
+
+#include "glm/glm.hpp"
+#include "glm/gtc/constants.hpp"
+
+#include "sdf_tape.h"
+#include "util/check.h"
+#include "util/debug.hpp"
+#include "world/gameobject.hpp"
+#include "world/transform.h"
+
+namespace Vkxel {
+
+    SDFTape::SDFTape(const SDFSurface &root) {
+        // Node 0 is the root, evaluated at the input position without transform
+        _node_data.push_back({.transform = glm::mat4{1.0f}, .scale = 1.0f});
+        CompileNode(root, 1, 0);
+        Emit(OpCode::End);
+    }
+
+    const std::vector<SDFTape::Instruction> &SDFTape::GetInstructions() const { return _instruction; }
+
+    const std::vector<SDFTape::NodeData> &SDFTape::GetNodeData() const { return _node_data; }
+
+    void SDFTape::CompileNode(const SDFSurface &node, const uint32_t positionDepth, const uint32_t valueDepth) {
+        CHECK(valueDepth < StackSize, "SDF Tape Value Stack Overflow");
+
+        switch (node.surfaceType) {
+            case SurfaceType::Primitive:
+                if (node.primitiveType == PrimitiveType::None) {
+                    Emit(OpCode::Constant, 0, glm::vec4{std::numeric_limits<float>::max()});
+                } else {
+                    Emit(OpCode::Primitive, static_cast<uint32_t>(node.primitiveType));
+                }
+                break;
+            case SurfaceType::CSG:
+                CompileChildren(node, positionDepth, valueDepth, node.csgType, node.csgSmoothFactor);
+                break;
+            case SurfaceType::Repetition:
+                if (node.repetitionType == RepetitionType::None) {
+                    Emit(OpCode::Constant, 0, glm::vec4{std::numeric_limits<float>::max()});
+                    break;
+                }
+                CHECK(positionDepth < StackSize, "SDF Tape Position Stack Overflow");
+                CompileFold(node);
+                CompileChildren(node, positionDepth + 1, valueDepth, CSGType::Unionize, 0.0f);
+                Emit(OpCode::PopPosition);
+                break;
+            case SurfaceType::Custom:
+                Debug::LogWarning("Custom SDF \"{}\" Can Not Be Evaluated On GPU", node.gameObject.name);
+                Emit(OpCode::Constant, 0, glm::vec4{std::numeric_limits<float>::max()});
+                break;
+            default:
+                Emit(OpCode::Constant, 0, glm::vec4{std::numeric_limits<float>::max()});
+                break;
+        }
+    }
+
+    void SDFTape::CompileChildren(const SDFSurface &node, const uint32_t positionDepth, const uint32_t valueDepth,
+                                  const CSGType type, const float smoothFactor) {
+        uint32_t child_count = 0;
+        if (type != CSGType::None) {
+            for (const auto &child_wrapper: node.gameObject.transform.GetChildren()) {
+                Transform &child = child_wrapper;
+                auto child_sdf_surface = child.gameObject.GetComponent<SDFSurface>();
+                if (!child_sdf_surface) {
+                    continue;
+                }
+
+                CHECK(positionDepth < StackSize, "SDF Tape Position Stack Overflow");
+
+                // Same transform and scale as SDFSurface::GetChildSDF
+                const uint32_t node_index = static_cast<uint32_t>(_node_data.size());
+                _node_data.push_back({.transform = child.GetRelativeToLocalMatrix(),
+                                      .scale = std::min({child.scale.x, child.scale.y, child.scale.z})});
+
+                // The first child initializes the value, later ones are combined into it
+                Emit(OpCode::PushChild, node_index);
+                CompileNode(child_sdf_surface.value(), positionDepth + 1, valueDepth + std::min(child_count, 1u));
+                Emit(OpCode::PopChild, node_index);
+                if (child_count > 0) {
+                    Emit(OpCode::Combine, static_cast<uint32_t>(type), glm::vec4{smoothFactor, 0, 0, 0});
+                }
+                ++child_count;
+            }
+        }
+
+        if (child_count == 0) {
+            const float empty_value = type == CSGType::Intersect ? std::numeric_limits<float>::lowest()
+                                                                 : std::numeric_limits<float>::max();
+            Emit(OpCode::Constant, 0, glm::vec4{empty_value});
+        }
+    }
+
+    void SDFTape::CompileFold(const SDFSurface &node) {
+        // Same folds as SDFSurface::GetRepetitionFold
+        const glm::vec3 spacing = glm::max(node.repetitionSpacing, glm::vec3{std::numeric_limits<float>::epsilon()});
+        const uint32_t type = static_cast<uint32_t>(node.repetitionType);
+
+        switch (node.repetitionType) {
+            case RepetitionType::Grid:
+                Emit(OpCode::Fold, type, glm::vec4{spacing, 0});
+                break;
+            case RepetitionType::FiniteGrid:
+                Emit(OpCode::Fold, type, glm::vec4{spacing, 0},
+                     glm::vec4{glm::vec3(glm::max(node.repetitionLimit, glm::ivec3{0})), 0});
+                break;
+            case RepetitionType::Mirror:
+                Emit(OpCode::Fold, type,
+                     glm::vec4{glm::vec3(glm::notEqual(node.repetitionMirrorAxis, glm::ivec3{0})), 0});
+                break;
+            case RepetitionType::Polar:
+                Emit(OpCode::Fold, type,
+                     glm::vec4{glm::two_pi<float>() / static_cast<float>(std::max(node.repetitionPolarCount, 1)), 0,
+                               0, 0});
+                break;
+            default:
+                break;
+        }
+    }
+
+    void SDFTape::Emit(const OpCode opCode, const uint32_t argument, const glm::vec4 &parameter0,
+                       const glm::vec4 &parameter1) {
+        _instruction.push_back(
+                {.opCode = opCode, .argument = argument, .parameter0 = parameter0, .parameter1 = parameter1});
+    }
+
+} // namespace Vkxel
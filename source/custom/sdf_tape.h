@@ -0,0 +1,75 @@
+//
+// Created by jiayi on 10/19/2026.
+//
+
+#ifndef VKXEL_SDF_TAPE_H
+#define VKXEL_SDF_TAPE_H
+
+#include <cstdint>
+#include <vector>
+
+#include "glm/glm.hpp"
+
+#include "sdf_shader_generator.h"
+#include "sdf_surface.h"
+
+namespace Vkxel {
+
+    // Flatten an SDFSurface hierarchy into a stack machine tape interpreted by shader/sdf_tape.slang,
+    // editing the tree only changes buffer content so the pipeline never has to be rebuilt
+    class SDFTape {
+    public:
+        // Matches SDF_TAPE_* in shader/sdf_tape.slang
+        enum class OpCode : uint32_t {
+            End,
+            // Push position transformed by node argument
+            PushChild,
+            // Scale value by node argument and pop position
+            PopChild,
+            // Push primitive argument evaluated at top position
+            Primitive,
+            // Push parameter0.x
+            Constant,
+            // Pop new value and accumulated value, push CSGType argument of both with smooth factor parameter0.x
+            Combine,
+            // Push top position folded by RepetitionType argument
+            Fold,
+            // Pop position
+            PopPosition,
+        };
+
+        // Matches SDFTapeInstruction in shader/sdf_tape.slang
+        struct Instruction {
+            OpCode opCode;
+            uint32_t argument;
+            glm::vec4 parameter0;
+            glm::vec4 parameter1;
+        };
+
+        using NodeData = SDFShaderGenerator::NodeData;
+
+        static constexpr uint32_t TapeBufferBinding = 7;
+        // Must match SDF_TAPE_STACK_SIZE in shader/sdf_tape.slang
+        static constexpr uint32_t StackSize = 16;
+
+        explicit SDFTape(const SDFSurface &root);
+
+        const std::vector<Instruction> &GetInstructions() const;
+        const std::vector<NodeData> &GetNodeData() const;
+
+    private:
+        void CompileNode(const SDFSurface &node, uint32_t positionDepth, uint32_t valueDepth);
+        void CompileChildren(const SDFSurface &node, uint32_t positionDepth, uint32_t valueDepth, CSGType type,
+                             float smoothFactor);
+        void CompileFold(const SDFSurface &node);
+
+        void Emit(OpCode opCode, uint32_t argument = 0, const glm::vec4 &parameter0 = {},
+                  const glm::vec4 &parameter1 = {});
+
+        std::vector<Instruction> _instruction;
+        std::vector<NodeData> _node_data;
+    };
+
+} // namespace Vkxel
+
+#endif // VKXEL_SDF_TAPE_H
@@ -0,0 +1,62 @@
+//
+// Created by jiayi on 10/19/2026.
+//
+
+#include <memory>
+
+#include "glm/glm.hpp"
+
+#include "sdf_volume.h"
+#include "util/check.h"
+
+namespace Vkxel {
+
+    glm::vec3 SDFVolume::GetMaxBound() const { return minBound + glm::vec3(size - glm::uvec3{1}) / resolution; }
+
+    size_t SDFVolume::GetIndex1D(const glm::uvec3 &index) const {
+        return (static_cast<size_t>(index.x) * size.y + index.y) * size.z + index.z;
+    }
+
+    float SDFVolume::GetValue(const glm::uvec3 &index) const { return value[GetIndex1D(index)]; }
+
+    void SDFVolume::SetValue(const glm::uvec3 &index, const float distance) { value[GetIndex1D(index)] = distance; }
+
+    float SDFVolume::Sample(const glm::vec3 &position) const {
+        CHECK(glm::all(glm::greaterThanEqual(size, glm::uvec3{2})), "SDF Volume Requires At Least 2 Points Per Axis");
+
+        const glm::vec3 max_index = glm::vec3(size - glm::uvec3{1});
+        const glm::vec3 grid_position = (position - minBound) * resolution;
+        const glm::vec3 clamped_position = glm::clamp(grid_position, glm::vec3{0}, max_index);
+
+        // Outside the volume the baked value is only a lower bound, add the distance to the volume
+        const float outside_distance = glm::length(grid_position - clamped_position) / resolution;
+
+        const glm::uvec3 p0 = glm::min(glm::uvec3(clamped_position), size - glm::uvec3{2});
+        const glm::vec3 t = clamped_position - glm::vec3(p0);
+
+        const float v000 = GetValue(p0);
+        const float v100 = GetValue(p0 + glm::uvec3{1, 0, 0});
+        const float v010 = GetValue(p0 + glm::uvec3{0, 1, 0});
+        const float v110 = GetValue(p0 + glm::uvec3{1, 1, 0});
+        const float v001 = GetValue(p0 + glm::uvec3{0, 0, 1});
+        const float v101 = GetValue(p0 + glm::uvec3{1, 0, 1});
+        const float v011 = GetValue(p0 + glm::uvec3{0, 1, 1});
+        const float v111 = GetValue(p0 + glm::uvec3{1, 1, 1});
+
+        const float v00 = glm::mix(v000, v100, t.x);
+        const float v10 = glm::mix(v010, v110, t.x);
+        const float v01 = glm::mix(v001, v101, t.x);
+        const float v11 = glm::mix(v011, v111, t.x);
+
+        const float v0 = glm::mix(v00, v10, t.y);
+        const float v1 = glm::mix(v01, v11, t.y);
+
+        return glm::mix(v0, v1, t.z) + outside_distance;
+    }
+
+    SDFType SDFVolume::GetSDF() const {
+        auto volume = std::make_shared<const SDFVolume>(*this);
+        return [volume](SDFInputType p) { return volume->Sample(p); };
+    }
+
+} // namespace Vkxel
@@ -0,0 +1,39 @@
+//
+// Created by jiayi on 10/19/2026.
+//
+
+#ifndef VKXEL_SDF_VOLUME_H
+#define VKXEL_SDF_VOLUME_H
+
+#include <cstdint>
+#include <vector>
+
+#include "glm/glm.hpp"
+
+#include "sdf_surface.h"
+
+namespace Vkxel {
+
+    // Baked SDF sampled on a regular lattice, point (x, y, z) lies at minBound + (x, y, z) / resolution
+    struct SDFVolume {
+        glm::uvec3 size = {};
+        glm::vec3 minBound = {};
+        float resolution = 0;
+        std::vector<float> value;
+
+        glm::vec3 GetMaxBound() const;
+        size_t GetIndex1D(const glm::uvec3 &index) const;
+
+        float GetValue(const glm::uvec3 &index) const;
+        void SetValue(const glm::uvec3 &index, float distance);
+
+        // Trilinear sample, positions outside the volume are clamped and padded by the distance to the bound
+        float Sample(const glm::vec3 &position) const;
+
+        // The returned SDF shares the volume data instead of copying it for every closure copy
+        SDFType GetSDF() const;
+    };
+
+} // namespace Vkxel
+
+#endif // VKXEL_SDF_VOLUME_H
@@ -3,11 +3,17 @@
 //
 
 #include <format>
+#include <vector>
+
+#include "rfl/json.hpp"
 
 #include "editor.h"
 #include "engine/engine.h"
+#include "engine/file.h"
+#include "engine/gpu_profiler.h"
 #include "engine/vtime.h"
 #include "reflect/reflect.hpp"
+#include "vkutil/memory.h"
 
 namespace Vkxel {
 
@@ -25,9 +31,62 @@ namespace Vkxel {
             ImGui::Text(std::format("Resolution ({0}, {1})", _window->GetFrameBufferWidth(),
                                     _window->GetFrameBufferHeight())
                                 .data());
+            DrawMemoryStatistics();
+            DrawFrameStatistics();
+            ImGui::SeparatorText("GPU");
+            GpuProfiler::Instance().OnGUI();
         });
     }
 
+    void EditorEngine::DrawMemoryStatistics() {
+        constexpr double mebibyte = 1024.0 * 1024.0;
+
+        ImGui::SeparatorText("Memory");
+        const VmaAllocator allocator = _renderer->GetAllocator();
+        const std::vector<VmaBudget> budget = VkUtil::MemoryStatistics::GetHeapBudgets(allocator);
+        for (size_t heap = 0; heap < budget.size(); ++heap) {
+            ImGui::Text(std::format("Heap {0} {1:.1f} / {2:.1f} MiB", heap, budget[heap].usage / mebibyte,
+                                    budget[heap].budget / mebibyte)
+                                .data());
+        }
+        for (size_t index = 0; index < static_cast<size_t>(VkUtil::MemoryCategory::Count); ++index) {
+            const auto category = static_cast<VkUtil::MemoryCategory>(index);
+            const auto [bytes, count] = VkUtil::MemoryStatistics::Get(category);
+            ImGui::Text(std::format("{0} {1:.2f} MiB ({2})", VkUtil::GetMemoryCategoryName(category), bytes / mebibyte,
+                                    count)
+                                .data());
+        }
+        if (ImGui::SmallButton("Dump Memory Statistics")) {
+            File::WriteTextFile(MemoryStatisticsFile, VkUtil::MemoryStatistics::ToJson(allocator));
+        }
+    }
+
+    void EditorEngine::DrawFrameStatistics() {
+        ImGui::SeparatorText("Frame");
+        const FrameStatistics &statistics = _renderer->GetFrameStatistics();
+        ImGui::Text(std::format("Draw Calls {0} (Pipeline Binds {1}, Descriptor Set Binds {2})", statistics.drawCalls,
+                                statistics.pipelineBinds, statistics.descriptorSetBinds)
+                            .data());
+        if (statistics.hasPipelineStatistics) {
+            ImGui::Text(std::format("Vertices {0} Primitives {1}", statistics.inputAssemblyVertices,
+                                    statistics.inputAssemblyPrimitives)
+                                .data());
+            ImGui::Text(std::format("Clipped Primitives {0} Fragment Invocations {1}", statistics.clippingPrimitives,
+                                    statistics.fragmentShaderInvocations)
+                                .data());
+        }
+        ImGui::Text(std::format("Uploaded {0} CPU Meshes ({1} Host Bytes)", statistics.uploadedObjects,
+                                statistics.uploadedHostBytes)
+                            .data());
+        for (const auto &[mesher, triangle_count]: statistics.mesher) {
+            // Mesher names contain user object names, so they are never used as a format string
+            ImGui::TextUnformatted(std::format("{0} {1} Triangles", mesher, triangle_count).c_str());
+        }
+        if (ImGui::SmallButton("Dump Frame Statistics")) {
+            File::WriteTextFile(FrameStatisticsFile, rfl::json::write(statistics, rfl::json::pretty));
+        }
+    }
+
     void EditorEngine::SetupSceneUI() {
         _gui->AddItem("Scene", [&]() {
             for (auto &gameObject: _scene.GetGameObjectsView()) {
@@ -5,6 +5,8 @@
 #ifndef VKXEL_EDITOR_H
 #define VKXEL_EDITOR_H
 
+#include <string_view>
+
 #include "engine/engine.h"
 
 namespace Vkxel {
@@ -15,6 +17,8 @@ namespace Vkxel {
 
     private:
         void SetupDebugUI();
+        void DrawMemoryStatistics();
+        void DrawFrameStatistics();
         void SetupSceneUI();
         void SetupInspectorUI();
         void DrawGameObjectTree(GameObject &gameObject);
@@ -26,6 +30,9 @@ namespace Vkxel {
         std::string GetDisplayName(Object &object);
 
         GameObject *_active_gameobject = nullptr;
+
+        static constexpr std::string_view MemoryStatisticsFile = "memory_statistics.json";
+        static constexpr std::string_view FrameStatisticsFile = "frame_statistics.json";
     };
 
 } // namespace Vkxel
@@ -2,22 +2,46 @@
 // Created by jiayi on 4/3/2025.
 //
 
+#include <algorithm>
+#include <bit>
+#include <chrono>
+#include <format>
+#include <limits>
+#include <optional>
+#include <span>
+
 #include "compute.h"
+#include "compute_graph.h"
+#include "gpu_profiler.h"
+#include "pipeline_cache.h"
 #include "shader.h"
 #include "util/check.h"
+#include "util/debug.hpp"
 #include "vkutil/command.h"
 #include "vkutil/descriptor.h"
 
 namespace Vkxel {
 
     void ComputeJob::Init(const std::string_view shaderPath, const std::vector<std::string_view> &shaderKernels,
-                          const std::vector<VkDeviceSize> &bufferSize) {
-        // TODO: Allow ReInit
+                          const std::vector<VkDeviceSize> &bufferSize,
+                          const std::vector<ComputeBufferUsage> &bufferUsage,
+                          const std::vector<uint32_t> &specializationConstant, const uint32_t pushConstantSize) {
+        InitPipeline(shaderPath, shaderKernels, bufferSize.size(), specializationConstant, pushConstantSize);
+        InitBuffer(bufferSize, bufferUsage);
+    }
+
+    void ComputeJob::InitPipeline(const std::string_view shaderPath, const std::vector<std::string_view> &shaderKernels,
+                                  const size_t bufferCount, const std::vector<uint32_t> &specializationConstant,
+                                  const uint32_t pushConstantSize) {
         CHECK(!shaderKernels.empty(), "Must Contain At Least 1 Kernel");
+        CHECK(pushConstantSize <= MaxPushConstantSize && pushConstantSize % 4 == 0,
+              "Push Constant Size {} Must Be A Multiple Of 4 Up To {}", pushConstantSize, MaxPushConstantSize);
 
-        Destroy();
+        DestroyPipeline();
+
+        _push_constant.assign(pushConstantSize, std::byte{0});
 
-        std::vector<VkDescriptorSetLayoutBinding> descriptor_set_layout_binding(bufferSize.size());
+        std::vector<VkDescriptorSetLayoutBinding> descriptor_set_layout_binding(bufferCount);
         for (uint32_t index = 0; auto &binding: descriptor_set_layout_binding) {
             binding = {.binding = index++,
                        .descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
@@ -26,63 +50,74 @@ namespace Vkxel {
                        .pImmutableSamplers = nullptr};
         }
 
-        VkDescriptorSetLayoutCreateInfo descriptor_set_layout_create_info{
-                .sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO,
-                .bindingCount = static_cast<uint32_t>(descriptor_set_layout_binding.size()),
-                .pBindings = descriptor_set_layout_binding.data()};
+        // Jobs with the same buffer count share the layout, and pipelines too when shader and kernels match
+        _descriptor_set_layout = _pipeline_registry->AcquireDescriptorSetLayout(descriptor_set_layout_binding);
 
-        CHECK_RESULT_VK(vkCreateDescriptorSetLayout(_device, &descriptor_set_layout_create_info, nullptr,
-                                                    &_descriptor_set_layout));
-
-
-        _descriptor_set = VkUtil::DescriptorSetBuilder(_device, _descriptor_pool, _descriptor_set_layout).Build();
+        _descriptor_set = VkUtil::DescriptorSetBuilder(_device, *_descriptor_allocator, _descriptor_set_layout).Build();
         _descriptor_set.Create();
 
-        std::vector<VkDescriptorBufferInfo> descriptor_buffer_info(bufferSize.size());
-        std::vector<VkWriteDescriptorSet> descriptor_set_write_info(bufferSize.size());
-
-        VkUtil::BufferBuilder buffer_builder =
-                VkUtil::BufferBuilder(_device, _allocator)
-                        .SetPQueueFamilyIndices(&_queue_family)
-                        .SetAllocationFlags(VMA_ALLOCATION_CREATE_HOST_ACCESS_SEQUENTIAL_WRITE_BIT)
-                        .SetUsage(VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_SRC_BIT |
-                                  VK_BUFFER_USAGE_TRANSFER_DST_BIT)
-                        .SetMemoryUsage(VMA_MEMORY_USAGE_AUTO)
-                        .SetRequiredFlags(VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT);
-
-        _compute_buffer.resize(bufferSize.size());
-        for (uint32_t index = 0; index < bufferSize.size(); ++index) {
-            _compute_buffer[index] = buffer_builder.SetSize(bufferSize[index]).Build();
-            _compute_buffer[index].Create();
-
-            descriptor_buffer_info[index] = {
-                    .buffer = _compute_buffer[index].buffer, .offset = 0, .range = VK_WHOLE_SIZE};
-            descriptor_set_write_info[index] = {
-                    .sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET,
-                    .dstSet = _descriptor_set.set,
-                    .dstBinding = index,
-                    .dstArrayElement = 0,
-                    .descriptorCount = 1,
-                    .descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
-                    .pBufferInfo = &descriptor_buffer_info[index],
-            };
+        // Buffers outside the new layout are dropped, the others are rebound to the new descriptor set
+        if (bufferCount < _compute_buffer.size()) {
+            WaitConsumer();
+        }
+        for (size_t index = bufferCount; index < _compute_buffer.size(); ++index) {
+            _compute_buffer[index].Destroy();
+        }
+        _compute_buffer.resize(std::min(_compute_buffer.size(), bufferCount));
+        _buffer_size.resize(_compute_buffer.size());
+        _buffer_usage.resize(_compute_buffer.size());
+        for (size_t index = 0; index < _compute_buffer.size(); ++index) {
+            WriteDescriptor(index);
         }
 
-        vkUpdateDescriptorSets(_device, static_cast<uint32_t>(descriptor_set_write_info.size()),
-                               descriptor_set_write_info.data(), 0, nullptr);
-
-        VkShaderModule shader_module = ShaderLoader::Instance().LoadToModule(_device, shaderPath);
+        const std::vector<uint8_t> shader_code = ShaderLoader::Instance().LoadToBinary(shaderPath);
 
+        const auto build_start = std::chrono::steady_clock::now();
         _compute_pipeline.reserve(shaderKernels.size());
         for (const auto &kernel: shaderKernels) {
             _compute_pipeline.push_back(VkUtil::ComputePipelineBuilder(_device)
-                                                .SetShader(shader_module)
+                                                .SetShaderCode(shader_code)
                                                 .SetShaderName(kernel)
                                                 .SetPipelineLayout({_descriptor_set_layout})
+                                                .SetSpecializationConstant(specializationConstant)
+                                                .SetPushConstantSize(pushConstantSize)
+                                                .SetPipelineCache(PipelineCache::Instance().Get())
+                                                .SetPipelineRegistry(*_pipeline_registry)
                                                 .Build());
+            _kernel_name.push_back(std::format("{} {}", shaderPath, kernel));
         }
+        Debug::Log("Compute Pipelines Of {} Built In {:.3f} ms", shaderPath,
+                   std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - build_start).count());
+    }
+
+    void ComputeJob::InitBuffer(const std::vector<VkDeviceSize> &bufferSize,
+                                const std::vector<ComputeBufferUsage> &bufferUsage) {
+        CHECK(_descriptor_set_layout, "Compute Job Require Init Pipeline");
+
+        _compute_buffer.resize(bufferSize.size());
+        _buffer_size.resize(bufferSize.size(), 0);
+        _buffer_usage.resize(bufferSize.size(), ComputeBufferUsage::Shared);
+
+        for (size_t index = 0; index < bufferSize.size(); ++index) {
+            const ComputeBufferUsage usage =
+                    index < bufferUsage.size() ? bufferUsage[index] : ComputeBufferUsage::Shared;
+            if (_compute_buffer[index].buffer && _buffer_usage[index] != usage) {
+                _immediate_command_pool.WaitIdle();
+                WaitConsumer();
+                _compute_buffer[index].Destroy();
+                _compute_buffer[index] = {};
+            }
+            _buffer_usage[index] = usage;
+            ResizeBuffer(index, bufferSize[index]);
+        }
+    }
 
-        vkDestroyShaderModule(_device, shader_module, nullptr);
+    bool ComputeJob::HasPipeline() const { return !_compute_pipeline.empty(); }
+
+    void ComputeJob::SetPushConstant(const std::byte *data, const size_t size) {
+        CHECK(size == _push_constant.size(), "Push Constant Size {} Not Match Declared Size {}", size,
+              _push_constant.size());
+        std::copy_n(data, size, _push_constant.data());
     }
 
     void ComputeJob::Dispatch(const VkCommandBuffer commandBuffer, const size_t kernel, const glm::uvec3 group) {
@@ -90,82 +125,392 @@ namespace Vkxel {
         vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, _compute_pipeline[kernel].pipeline);
         vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, _compute_pipeline[kernel].layout, 0, 1,
                                 &_descriptor_set.set, 0, nullptr);
+        if (!_push_constant.empty()) {
+            vkCmdPushConstants(commandBuffer, _compute_pipeline[kernel].layout, VK_SHADER_STAGE_COMPUTE_BIT, 0,
+                               static_cast<uint32_t>(_push_constant.size()), _push_constant.data());
+        }
+        GpuProfiler::Scope zone(commandBuffer, _kernel_name[kernel], _queue_family);
         vkCmdDispatch(commandBuffer, group.x, group.y, group.z);
     }
 
     void ComputeJob::DispatchImmediate(const size_t kernel, const glm::uvec3 group) {
-        VkUtil::ImmediateCommand immediate_command(_device, _queue, _command_pool);
+        VkUtil::ImmediateCommand immediate_command(_immediate_command_pool);
         VkCommandBuffer command_buffer = immediate_command.Begin();
+        AddConsumerWait(immediate_command);
         Dispatch(command_buffer, kernel, group);
         immediate_command.End();
     }
 
+    void ComputeJob::Dispatch(const VkCommandBuffer commandBuffer, const std::vector<DispatchInfo> &dispatches) {
+        for (size_t index = 0; index < dispatches.size(); ++index) {
+            if (index > 0) {
+                CmdComputeBarrier(commandBuffer);
+            }
+            Dispatch(commandBuffer, dispatches[index].kernel, dispatches[index].group);
+        }
+    }
+
+    void ComputeJob::DispatchImmediate(const std::vector<DispatchInfo> &dispatches) {
+        DispatchImmediate([&](const VkCommandBuffer commandBuffer) { Dispatch(commandBuffer, dispatches); });
+    }
+
+    void ComputeJob::DispatchImmediate(const ComputeGraph &graph) {
+        DispatchImmediate([&](const VkCommandBuffer commandBuffer) { graph.Record(commandBuffer); });
+    }
+
+    void ComputeJob::DispatchImmediate(const std::function<void(VkCommandBuffer)> &record) {
+        VkUtil::ImmediateCommand immediate_command(_immediate_command_pool);
+        VkCommandBuffer command_buffer = immediate_command.Begin();
+        AddConsumerWait(immediate_command);
+        {
+            std::optional<GpuProfiler::Scope> zone;
+            if (!_profile_zone.empty()) {
+                zone.emplace(command_buffer, _profile_zone, _queue_family);
+            }
+            record(command_buffer);
+        }
+        CmdHostReadBarrier(command_buffer);
+        immediate_command.End();
+    }
+
+    uint64_t ComputeJob::Submit(const std::vector<DispatchInfo> &dispatches) {
+        return Submit([&](const VkCommandBuffer commandBuffer) { Dispatch(commandBuffer, dispatches); });
+    }
+
+    uint64_t ComputeJob::Submit(const ComputeGraph &graph) {
+        return Submit([&](const VkCommandBuffer commandBuffer) { graph.Record(commandBuffer); });
+    }
+
+    uint64_t ComputeJob::Submit(const std::function<void(VkCommandBuffer)> &record) {
+        VkUtil::ImmediateCommand immediate_command(_immediate_command_pool);
+        VkCommandBuffer command_buffer = immediate_command.Begin();
+
+        AddConsumerWait(immediate_command);
+        {
+            std::optional<GpuProfiler::Scope> zone;
+            if (!_profile_zone.empty()) {
+                zone.emplace(command_buffer, _profile_zone, _queue_family);
+            }
+            record(command_buffer);
+        }
+        CmdHostReadBarrier(command_buffer);
+
+        return immediate_command.Submit().value;
+    }
+
+    void ComputeJob::Wait(const uint64_t value) const { _immediate_command_pool.Wait(value); }
+
+    bool ComputeJob::IsComplete(const uint64_t value) const { return _immediate_command_pool.IsComplete(value); }
+
+    VkSemaphore ComputeJob::GetTimelineSemaphore() const { return _immediate_command_pool.GetTimelineSemaphore(); }
+
+    uint32_t ComputeJob::GetQueueFamily() const { return _queue_family; }
+
+    void ComputeJob::SetProfileZone(const std::string_view name) { _profile_zone = name; }
+
+    void ComputeJob::SetConsumerTimeline(const VkSemaphore semaphore, const uint64_t value) {
+        _consumer_semaphore = semaphore;
+        _consumer_value = value;
+    }
+
+    void ComputeJob::AddConsumerWait(VkUtil::ImmediateCommand &immediateCommand) const {
+        // Kernels overwrite buffers the consumer may still be reading from earlier submissions
+        if (_consumer_semaphore && _consumer_value > 0) {
+            immediateCommand.AddWaitSemaphore(_consumer_semaphore, _consumer_value,
+                                              VK_PIPELINE_STAGE_2_ALL_COMMANDS_BIT);
+        }
+    }
+
+    void ComputeJob::WaitConsumer() const {
+        if (!_consumer_semaphore || _consumer_value == 0) {
+            return;
+        }
+        VkSemaphoreWaitInfo wait_info{.sType = VK_STRUCTURE_TYPE_SEMAPHORE_WAIT_INFO,
+                                      .semaphoreCount = 1,
+                                      .pSemaphores = &_consumer_semaphore,
+                                      .pValues = &_consumer_value};
+        CHECK_RESULT_VK(vkWaitSemaphores(_device, &wait_info, std::numeric_limits<uint64_t>::max()));
+    }
+
+    void ComputeJob::CmdComputeBarrier(const VkCommandBuffer commandBuffer) {
+        VkMemoryBarrier2 memory_barrier{.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER_2,
+                                        .srcStageMask = VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT,
+                                        .srcAccessMask = VK_ACCESS_2_SHADER_STORAGE_WRITE_BIT,
+                                        .dstStageMask = VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT,
+                                        .dstAccessMask = VK_ACCESS_2_SHADER_STORAGE_READ_BIT |
+                                                         VK_ACCESS_2_SHADER_STORAGE_WRITE_BIT};
+
+        VkDependencyInfo dependency_info{.sType = VK_STRUCTURE_TYPE_DEPENDENCY_INFO,
+                                         .memoryBarrierCount = 1,
+                                         .pMemoryBarriers = &memory_barrier};
+
+        vkCmdPipelineBarrier2(commandBuffer, &dependency_info);
+    }
+
+    void ComputeJob::CmdHostReadBarrier(const VkCommandBuffer commandBuffer) {
+        VkMemoryBarrier2 memory_barrier{.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER_2,
+                                        .srcStageMask = VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT,
+                                        .srcAccessMask = VK_ACCESS_2_SHADER_STORAGE_WRITE_BIT,
+                                        .dstStageMask = VK_PIPELINE_STAGE_2_HOST_BIT,
+                                        .dstAccessMask = VK_ACCESS_2_HOST_READ_BIT};
+
+        VkDependencyInfo dependency_info{.sType = VK_STRUCTURE_TYPE_DEPENDENCY_INFO,
+                                         .memoryBarrierCount = 1,
+                                         .pMemoryBarriers = &memory_barrier};
+
+        vkCmdPipelineBarrier2(commandBuffer, &dependency_info);
+    }
+
     VkUtil::Buffer &ComputeJob::GetBuffer(const size_t index) { return _compute_buffer[index]; }
 
+    void ComputeJob::ResizeBuffer(const size_t index, const VkDeviceSize size) {
+        CHECK(index < _compute_buffer.size(), "Compute Buffer Index Out Of Range");
+
+        _buffer_size[index] = size;
+
+        // Allocations come in power of two size classes and only grow, so shrinking or growing within the class
+        // keeps the buffer and its descriptor untouched
+        VkUtil::Buffer &compute_buffer = _compute_buffer[index];
+        if (compute_buffer.buffer && compute_buffer.createInfo.size >= size) {
+            return;
+        }
+
+        _immediate_command_pool.WaitIdle();
+
+        const VkDeviceSize capacity = std::bit_ceil(std::max<VkDeviceSize>(size, MinBufferCapacity));
+        if (compute_buffer.buffer) {
+            WaitConsumer();
+            compute_buffer.Destroy();
+        }
+        compute_buffer = CreateBuffer(capacity, _buffer_usage[index]);
+        compute_buffer.Create();
+
+        WriteDescriptor(index);
+    }
+
+    void ComputeJob::WriteDescriptor(const size_t index) {
+        VkDescriptorBufferInfo descriptor_buffer_info{
+                .buffer = _compute_buffer[index].buffer, .offset = 0, .range = VK_WHOLE_SIZE};
+        VkWriteDescriptorSet descriptor_set_write_info{
+                .sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET,
+                .dstSet = _descriptor_set.set,
+                .dstBinding = static_cast<uint32_t>(index),
+                .dstArrayElement = 0,
+                .descriptorCount = 1,
+                .descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
+                .pBufferInfo = &descriptor_buffer_info,
+        };
+
+        vkUpdateDescriptorSets(_device, 1, &descriptor_set_write_info, 0, nullptr);
+    }
+
     std::vector<std::byte> ComputeJob::ReadBuffer(const size_t index, const size_t offset, const size_t size) {
-        size_t buffer_size = size;
-        if (buffer_size == 0 || (buffer_size + offset) > _compute_buffer[index].createInfo.size) {
-            buffer_size = _compute_buffer[index].createInfo.size - offset;
-        }
-        std::vector<std::byte> data(buffer_size);
-        std::byte *ptr = _compute_buffer[index].Map();
-        std::copy_n(ptr + offset, buffer_size, data.data());
-        _compute_buffer[index].Unmap();
+        std::vector<std::byte> data(GetCopySize(index, offset, size));
+        ReadBuffer(index, data.data(), offset, data.size());
         return data;
     }
 
     void ComputeJob::WriteBuffer(const size_t index, const std::vector<std::byte> &data, const size_t offset,
                                  const size_t size) {
-        size_t buffer_size = size;
-        if (buffer_size == 0 || (buffer_size + offset) > _compute_buffer[index].createInfo.size) {
-            buffer_size = _compute_buffer[index].createInfo.size - offset;
-        }
-        CHECK(buffer_size == data.size(), "Buffer Size Not Match");
-        std::byte *ptr = _compute_buffer[index].Map();
-        std::copy_n(data.data(), buffer_size, ptr + offset);
-        _compute_buffer[index].Flush();
-        _compute_buffer[index].Unmap();
+        CHECK(GetCopySize(index, offset, size) == data.size(), "Buffer Size Not Match");
+        WriteBuffer(index, data.data(), offset, data.size());
     }
 
     void ComputeJob::ReadBuffer(const size_t index, std::byte *buffer, const size_t offset, const size_t size) {
-        size_t buffer_size = size;
-        if (buffer_size == 0 || (buffer_size + offset) > _compute_buffer[index].createInfo.size) {
-            buffer_size = _compute_buffer[index].createInfo.size - offset;
+        const size_t buffer_size = GetCopySize(index, offset, size);
+        VkUtil::Buffer &compute_buffer = _compute_buffer[index];
+
+        if (compute_buffer.IsHostVisible()) {
+            compute_buffer.Invalidate(offset, buffer_size);
+            std::byte *ptr = compute_buffer.Map();
+            std::copy_n(ptr + offset, buffer_size, buffer);
+            compute_buffer.Unmap();
+            return;
         }
-        std::byte *ptr = _compute_buffer[index].Map();
-        std::copy_n(ptr + offset, buffer_size, buffer);
-        _compute_buffer[index].Unmap();
+
+        VkUtil::Buffer &staging_buffer = GetStagingBuffer(buffer_size);
+
+        VkUtil::ImmediateCommand(_immediate_command_pool).Run([&](const VkCommandBuffer commandBuffer) {
+            VkBufferCopy copy_region{.srcOffset = offset, .dstOffset = 0, .size = buffer_size};
+            vkCmdCopyBuffer(commandBuffer, compute_buffer.buffer, staging_buffer.buffer, 1, &copy_region);
+        });
+
+        staging_buffer.Invalidate(0, buffer_size);
+        std::copy_n(staging_buffer.GetMappedData(), buffer_size, buffer);
     }
 
-    void ComputeJob::WriteBuffer(const size_t index, std::byte *buffer, const size_t offset, const size_t size) {
-        size_t buffer_size = size;
-        if (buffer_size == 0 || (buffer_size + offset) > _compute_buffer[index].createInfo.size) {
-            buffer_size = _compute_buffer[index].createInfo.size - offset;
+    void ComputeJob::WriteBuffer(const size_t index, const std::byte *buffer, const size_t offset,
+                                 const size_t size) {
+        const size_t buffer_size = GetCopySize(index, offset, size);
+        VkUtil::Buffer &compute_buffer = _compute_buffer[index];
+
+        if (compute_buffer.IsHostVisible()) {
+            std::byte *ptr = compute_buffer.Map();
+            std::copy_n(buffer, buffer_size, ptr + offset);
+            compute_buffer.Flush(offset, buffer_size);
+            compute_buffer.Unmap();
+            return;
         }
-        std::byte *ptr = _compute_buffer[index].Map();
-        std::copy_n(buffer, buffer_size, ptr + offset);
-        _compute_buffer[index].Flush();
-        _compute_buffer[index].Unmap();
+
+        VkUtil::Buffer &staging_buffer = GetStagingBuffer(buffer_size);
+
+        std::copy_n(buffer, buffer_size, staging_buffer.GetMappedData());
+        staging_buffer.Flush(0, buffer_size);
+
+        VkUtil::ImmediateCommand(_immediate_command_pool).Run([&](const VkCommandBuffer commandBuffer) {
+            VkBufferCopy copy_region{.srcOffset = 0, .dstOffset = offset, .size = buffer_size};
+            vkCmdCopyBuffer(commandBuffer, staging_buffer.buffer, compute_buffer.buffer, 1, &copy_region);
+        });
     }
 
-    void ComputeJob::Destroy() {
-        if (!_compute_pipeline.empty()) {
-            for (auto &buffer: _compute_buffer) {
-                buffer.Destroy();
+    std::span<std::byte> ComputeJob::GetMappedBuffer(const size_t index) {
+        CHECK(index < _compute_buffer.size(), "Compute Buffer Index Out Of Range");
+        std::byte *mapped_data = _compute_buffer[index].GetMappedData();
+        CHECK(mapped_data, "Compute Buffer {} Is Not Persistently Mapped", index);
+        return {mapped_data, _buffer_size[index]};
+    }
+
+    bool ComputeJob::IsBufferMapped(const size_t index) const {
+        return _compute_buffer[index].GetMappedData() != nullptr;
+    }
+
+    void ComputeJob::FlushBuffer(const size_t index, const size_t offset, const size_t size) {
+        _compute_buffer[index].Flush(offset, GetCopySize(index, offset, size));
+    }
+
+    void ComputeJob::InvalidateBuffer(const size_t index, const size_t offset, const size_t size) {
+        _compute_buffer[index].Invalidate(offset, GetCopySize(index, offset, size));
+    }
+
+    size_t ComputeJob::GetCopySize(const size_t index, const size_t offset, const size_t size) const {
+        const size_t buffer_size = _buffer_size[index];
+        if (size == 0 || (size + offset) > buffer_size) {
+            return buffer_size - offset;
+        }
+        return size;
+    }
+
+    VkUtil::Buffer ComputeJob::CreateBuffer(const VkDeviceSize size, const ComputeBufferUsage usage) const {
+        VkUtil::BufferBuilder buffer_builder =
+                VkUtil::BufferBuilder(_device, _allocator)
+                        .SetSize(size)
+                        .SetPQueueFamilyIndices(&_queue_family)
+                        .SetUsage(VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_SRC_BIT |
+                                  VK_BUFFER_USAGE_TRANSFER_DST_BIT);
+
+        // Consumers draw Shared and Output buffers directly, e.g. indirect arguments and generated meshes
+        if (usage == ComputeBufferUsage::Shared || usage == ComputeBufferUsage::Output) {
+            buffer_builder.SetUsage(VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_SRC_BIT |
+                                    VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_INDEX_BUFFER_BIT |
+                                    VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT);
+            if (_output_queue_family != _queue_family) {
+                buffer_builder.SetSharingMode(VK_SHARING_MODE_CONCURRENT)
+                        .SetQueueFamilyIndexCount(static_cast<uint32_t>(_buffer_queue_family.size()))
+                        .SetPQueueFamilyIndices(_buffer_queue_family.data());
             }
-            _compute_buffer = {};
+        }
+
+        switch (usage) {
+            case ComputeBufferUsage::Shared:
+                buffer_builder.SetAllocationFlags(VMA_ALLOCATION_CREATE_HOST_ACCESS_SEQUENTIAL_WRITE_BIT)
+                        .SetMemoryUsage(VMA_MEMORY_USAGE_AUTO)
+                        .SetRequiredFlags(VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT);
+                break;
+            case ComputeBufferUsage::Scratch:
+            case ComputeBufferUsage::Output:
+                buffer_builder.SetAllocationFlags(0)
+                        .SetMemoryUsage(VMA_MEMORY_USAGE_AUTO_PREFER_DEVICE)
+                        .SetRequiredFlags(0);
+                break;
+            case ComputeBufferUsage::Upload:
+                // Lands in ReBAR when available, otherwise device local and written through staging
+                buffer_builder
+                        .SetAllocationFlags(VMA_ALLOCATION_CREATE_HOST_ACCESS_SEQUENTIAL_WRITE_BIT |
+                                            VMA_ALLOCATION_CREATE_HOST_ACCESS_ALLOW_TRANSFER_INSTEAD_BIT)
+                        .SetMemoryUsage(VMA_MEMORY_USAGE_AUTO_PREFER_DEVICE)
+                        .SetRequiredFlags(0);
+                break;
+            case ComputeBufferUsage::Readback:
+                buffer_builder.SetAllocationFlags(VMA_ALLOCATION_CREATE_HOST_ACCESS_RANDOM_BIT)
+                        .SetMemoryUsage(VMA_MEMORY_USAGE_AUTO_PREFER_HOST)
+                        .SetRequiredFlags(VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT);
+                break;
+            default:
+                CHECK(nullptr, "Unknown Compute Buffer Usage");
+        }
+
+        // Host accessed buffers stay mapped, Upload falls back to staging when it lands outside host visible memory
+        return buffer_builder
+                .SetPersistentMapped(usage != ComputeBufferUsage::Scratch && usage != ComputeBufferUsage::Output)
+                .SetCategory(usage == ComputeBufferUsage::Output ? VkUtil::MemoryCategory::Mesh
+                                                                 : VkUtil::MemoryCategory::ComputeScratch)
+                .Build();
+    }
+
+    VkUtil::Buffer &ComputeJob::GetStagingBuffer(const VkDeviceSize size) {
+        if (_staging_buffer.buffer && _staging_buffer.createInfo.size >= size) {
+            return _staging_buffer;
+        }
+
+        if (_staging_buffer.buffer) {
+            _staging_buffer.Destroy();
+        }
+
+        // Used for both directions, random access keeps readback out of write combined memory
+        _staging_buffer = VkUtil::BufferBuilder(_device, _allocator)
+                                  .SetSize(std::bit_ceil(std::max<VkDeviceSize>(size, MinBufferCapacity)))
+                                  .SetUsage(VK_BUFFER_USAGE_TRANSFER_SRC_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT)
+                                  .SetPQueueFamilyIndices(&_queue_family)
+                                  .SetAllocationFlags(VMA_ALLOCATION_CREATE_HOST_ACCESS_RANDOM_BIT)
+                                  .SetMemoryUsage(VMA_MEMORY_USAGE_AUTO_PREFER_HOST)
+                                  .SetRequiredFlags(VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT)
+                                  .SetPersistentMapped()
+                                  .SetCategory(VkUtil::MemoryCategory::Staging)
+                                  .Build();
+        _staging_buffer.Create();
+        return _staging_buffer;
+    }
+
+    void ComputeJob::DestroyPipeline() {
+        if (!_compute_pipeline.empty()) {
+            _immediate_command_pool.WaitIdle();
 
             for (auto &pipeline: _compute_pipeline) {
                 pipeline.Destroy();
             }
             _compute_pipeline = {};
+            _kernel_name = {};
 
             _descriptor_set.Destroy();
-            vkDestroyDescriptorSetLayout(_device, _descriptor_set_layout, nullptr);
+            _pipeline_registry->ReleaseDescriptorSetLayout(_descriptor_set_layout);
+            _descriptor_set_layout = nullptr;
+        }
+    }
+
+    void ComputeJob::Destroy() {
+        DestroyPipeline();
+
+        if (!_compute_buffer.empty()) {
+            _immediate_command_pool.WaitIdle();
+            WaitConsumer();
+            for (auto &buffer: _compute_buffer) {
+                buffer.Destroy();
+            }
+            _compute_buffer = {};
+            _buffer_size = {};
+            _buffer_usage = {};
+        }
+
+        if (_staging_buffer.buffer) {
+            _staging_buffer.Destroy();
+            _staging_buffer = {};
         }
     }
 
-    ComputeJob::~ComputeJob() { Destroy(); }
+    ComputeJob::~ComputeJob() {
+        Destroy();
+        _immediate_command_pool.Destroy();
+    }
 
 
 } // namespace Vkxel
@@ -5,7 +5,13 @@
 #ifndef VKXEL_COMPUTE_H
 #define VKXEL_COMPUTE_H
 
+#include <array>
+#include <cstdint>
+#include <functional>
+#include <span>
+#include <string>
 #include <string_view>
+#include <type_traits>
 #include <vector>
 
 #include "glm/glm.hpp"
@@ -13,46 +19,171 @@
 #include "vulkan/vulkan_core.h"
 
 #include "vkutil/buffer.h"
+#include "vkutil/command.h"
 #include "vkutil/descriptor.h"
 #include "vkutil/pipeline.h"
+#include "vkutil/pipeline_registry.h"
 
 namespace Vkxel {
 
+    class ComputeGraph;
+
+    enum class ComputeBufferUsage {
+        // Host visible and device accessible, the previous default
+        Shared,
+        // Device local, only touched by kernels
+        Scratch,
+        // Written by host every dispatch, device local when host visible memory allows
+        Upload,
+        // Written by kernels and read back by host
+        Readback,
+        // Device local, written by kernels and drawn by graphics as index, vertex or indirect buffer
+        Output,
+    };
+
     class ComputeJob {
     public:
+        struct DispatchInfo {
+            size_t kernel;
+            glm::uvec3 group;
+        };
+
+        // Output queue family reads Shared and Output buffers, they are created concurrent with it so no ownership
+        // transfer is needed and a consumer can keep reading them across several frames
         ComputeJob(const VkDevice device, const uint32_t queueFamily, const VkQueue queue,
-                   const VkCommandPool commandPool, const VkDescriptorPool descriptorPool,
-                   const VmaAllocator allocator) :
+                   const VkCommandPool commandPool, VkUtil::DescriptorAllocator &descriptorAllocator,
+                   VkUtil::PipelineRegistry &pipelineRegistry, const VmaAllocator allocator,
+                   const uint32_t outputQueueFamily = VK_QUEUE_FAMILY_IGNORED) :
             _device(device), _queue_family(queueFamily), _queue(queue), _command_pool(commandPool),
-            _descriptor_pool(descriptorPool), _allocator(allocator) {}
+            _descriptor_allocator(&descriptorAllocator), _pipeline_registry(&pipelineRegistry), _allocator(allocator),
+            _output_queue_family(outputQueueFamily == VK_QUEUE_FAMILY_IGNORED ? queueFamily : outputQueueFamily),
+            _buffer_queue_family{_queue_family, _output_queue_family},
+            _immediate_command_pool(device, queue, commandPool) {}
 
+        static constexpr VkDeviceSize MinBufferCapacity = 256;
+        // Minimum maxPushConstantsSize guaranteed by Vulkan
+        static constexpr uint32_t MaxPushConstantSize = 128;
+
+        // Buffers without a usage fall back to ComputeBufferUsage::Shared,
+        // specialization constants apply to every kernel with constant_id as the index in the vector,
+        // a non-zero push constant size declares the block set by SetPushConstant for every kernel
         void Init(std::string_view shaderPath, const std::vector<std::string_view> &shaderKernels,
-                  const std::vector<VkDeviceSize> &bufferSize);
+                  const std::vector<VkDeviceSize> &bufferSize, const std::vector<ComputeBufferUsage> &bufferUsage = {},
+                  const std::vector<uint32_t> &specializationConstant = {}, uint32_t pushConstantSize = 0);
+        // Rebuild descriptor set layout and pipelines only, existing buffers within bufferCount are kept and rebound
+        void InitPipeline(std::string_view shaderPath, const std::vector<std::string_view> &shaderKernels,
+                          size_t bufferCount, const std::vector<uint32_t> &specializationConstant = {},
+                          uint32_t pushConstantSize = 0);
+        // Resize every buffer after InitPipeline, buffers keeping their usage are reused when they fit
+        void InitBuffer(const std::vector<VkDeviceSize> &bufferSize,
+                        const std::vector<ComputeBufferUsage> &bufferUsage = {});
+        bool HasPipeline() const;
+
+        // Recorded with each following dispatch, so changing it never touches a buffer
+        template<typename T>
+            requires std::is_trivially_copyable_v<T>
+        void SetPushConstant(const T &value) {
+            SetPushConstant(reinterpret_cast<const std::byte *>(&value), sizeof(T));
+        }
+        void SetPushConstant(const std::byte *data, size_t size);
 
         void Dispatch(VkCommandBuffer commandBuffer, size_t kernel, glm::uvec3 group);
         void DispatchImmediate(size_t kernel, glm::uvec3 group);
 
+        // Record kernels in order with a barrier between each, so later kernels see earlier writes
+        void Dispatch(VkCommandBuffer commandBuffer, const std::vector<DispatchInfo> &dispatches);
+        // Record all kernels into one command buffer and wait for a single submission
+        void DispatchImmediate(const std::vector<DispatchInfo> &dispatches);
+        void DispatchImmediate(const ComputeGraph &graph);
+
+        // Submit without waiting on host and return the timeline value signaled on completion
+        uint64_t Submit(const std::vector<DispatchInfo> &dispatches);
+        uint64_t Submit(const ComputeGraph &graph);
+        // Block until the timeline reaches value, 0 returns immediately
+        void Wait(uint64_t value) const;
+        // Poll the timeline without blocking
+        bool IsComplete(uint64_t value) const;
+        VkSemaphore GetTimelineSemaphore() const;
+        uint32_t GetQueueFamily() const;
+
+        // Wrap every following submission in a GPU profiler zone of this name, empty disables it
+        void SetProfileZone(std::string_view name);
+        // Shared and Output buffers are read by the consumer until its timeline semaphore reaches value,
+        // following submissions wait for it on device and destroying those buffers waits for it on host
+        void SetConsumerTimeline(VkSemaphore semaphore, uint64_t value);
+
+        static void CmdComputeBarrier(VkCommandBuffer commandBuffer);
+        static void CmdHostReadBarrier(VkCommandBuffer commandBuffer);
+
         VkUtil::Buffer &GetBuffer(size_t index);
+        // Buffers are allocated in power of two size classes that only grow, a larger class is recreated and
+        // rebound with its content discarded, otherwise only the size seen by Read and Write changes
+        void ResizeBuffer(size_t index, VkDeviceSize size);
+        // Buffers that are not host visible are read and written through a reused staging buffer
         std::vector<std::byte> ReadBuffer(size_t index, size_t offset = 0, size_t size = 0);
         void WriteBuffer(size_t index, const std::vector<std::byte> &data, size_t offset = 0, size_t size = 0);
         void ReadBuffer(size_t index, std::byte *buffer, size_t offset = 0, size_t size = 0);
-        void WriteBuffer(size_t index, std::byte *buffer, size_t offset = 0, size_t size = 0);
+        void WriteBuffer(size_t index, const std::byte *buffer, size_t offset = 0, size_t size = 0);
 
+        // Zero-copy view of a persistently mapped buffer, host writes need FlushBuffer and device writes need
+        // InvalidateBuffer on memory that is not host coherent
+        std::span<std::byte> GetMappedBuffer(size_t index);
+        template<typename T>
+        std::span<T> GetMappedBuffer(size_t index) {
+            std::span<std::byte> mapped_buffer = GetMappedBuffer(index);
+            return {reinterpret_cast<T *>(mapped_buffer.data()), mapped_buffer.size() / sizeof(T)};
+        }
+        bool IsBufferMapped(size_t index) const;
+        void FlushBuffer(size_t index, size_t offset = 0, size_t size = 0);
+        void InvalidateBuffer(size_t index, size_t offset = 0, size_t size = 0);
+
+        void DestroyPipeline();
         void Destroy();
 
         ~ComputeJob();
 
     private:
+        void DispatchImmediate(const std::function<void(VkCommandBuffer)> &record);
+        uint64_t Submit(const std::function<void(VkCommandBuffer)> &record);
+
+        void AddConsumerWait(VkUtil::ImmediateCommand &immediateCommand) const;
+        // Called before Shared or Output buffers are destroyed
+        void WaitConsumer() const;
+
+        void WriteDescriptor(size_t index);
+
+        size_t GetCopySize(size_t index, size_t offset, size_t size) const;
+        VkUtil::Buffer CreateBuffer(VkDeviceSize size, ComputeBufferUsage usage) const;
+        // Grow only staging buffer shared by reads and writes, persistently mapped
+        VkUtil::Buffer &GetStagingBuffer(VkDeviceSize size);
+
         VkDevice _device = nullptr;
         uint32_t _queue_family = 0;
         VkQueue _queue = nullptr;
         VkCommandPool _command_pool = nullptr;
-        VkDescriptorPool _descriptor_pool = nullptr;
+        VkUtil::DescriptorAllocator *_descriptor_allocator = nullptr;
+        VkUtil::PipelineRegistry *_pipeline_registry = nullptr;
         VmaAllocator _allocator = nullptr;
+        uint32_t _output_queue_family = 0;
+        // Queue families of concurrent buffers, only used when the output queue family differs
+        std::array<uint32_t, 2> _buffer_queue_family = {};
+
+        // Every submission of the job, Submit values are its timeline values
+        VkUtil::ImmediateCommandPool _immediate_command_pool;
+        VkSemaphore _consumer_semaphore = nullptr;
+        uint64_t _consumer_value = 0;
+        std::vector<std::byte> _push_constant = {};
 
         VkDescriptorSetLayout _descriptor_set_layout = nullptr;
         std::vector<VkUtil::Buffer> _compute_buffer = {};
+        // Requested size of each buffer, the allocation may be larger
+        std::vector<VkDeviceSize> _buffer_size = {};
+        std::vector<ComputeBufferUsage> _buffer_usage = {};
+        VkUtil::Buffer _staging_buffer = {};
         std::vector<VkUtil::ComputePipeline> _compute_pipeline = {};
+        // GPU profiler zone of each kernel
+        std::vector<std::string> _kernel_name = {};
+        std::string _profile_zone = {};
         VkUtil::DescriptorSet _descriptor_set = {};
     };
 
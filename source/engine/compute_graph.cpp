@@ -0,0 +1,120 @@
+//
+// Created by jiayi on 10/19/2026.
+//
+
+#include <algorithm>
+#include <set>
+#include <vector>
+
+#include "compute.h"
+#include "compute_graph.h"
+
+namespace Vkxel {
+
+    ComputeGraph &ComputeGraph::AddNode(const Node &node) {
+        _nodes.push_back(node);
+        return *this;
+    }
+
+    ComputeGraph &ComputeGraph::AddNode(const std::vector<Node> &nodes) {
+        _nodes.insert(_nodes.end(), nodes.begin(), nodes.end());
+        return *this;
+    }
+
+    void ComputeGraph::Record(const VkCommandBuffer commandBuffer) const {
+        // Accesses not yet covered by a barrier
+        std::set<size_t> pending_read;
+        std::set<size_t> pending_write;
+
+        for (const auto &batch: GetBatches()) {
+            std::set<size_t> batch_read;
+            std::set<size_t> batch_write;
+            for (const size_t node: batch) {
+                batch_read.insert(_nodes[node].read.begin(), _nodes[node].read.end());
+                batch_write.insert(_nodes[node].write.begin(), _nodes[node].write.end());
+            }
+
+            std::set<size_t> batch_access = batch_read;
+            batch_access.insert(batch_write.begin(), batch_write.end());
+
+            // Read after write and write after write need memory visibility, write after read only execution order
+            std::vector<VkBufferMemoryBarrier2> buffer_memory_barrier;
+            for (const size_t buffer: batch_access) {
+                const bool written = pending_write.contains(buffer);
+                const bool write = batch_write.contains(buffer);
+                if (!written && !(write && pending_read.contains(buffer))) {
+                    continue;
+                }
+
+                buffer_memory_barrier.push_back(
+                        {.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER_2,
+                         .srcStageMask = VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT,
+                         .srcAccessMask = written ? VK_ACCESS_2_SHADER_STORAGE_WRITE_BIT : VK_ACCESS_2_NONE,
+                         .dstStageMask = VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT,
+                         .dstAccessMask = VK_ACCESS_2_SHADER_STORAGE_READ_BIT |
+                                          (write ? VK_ACCESS_2_SHADER_STORAGE_WRITE_BIT : VK_ACCESS_2_NONE),
+                         .srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+                         .dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+                         .buffer = _compute_job.GetBuffer(buffer).buffer,
+                         .offset = 0,
+                         .size = VK_WHOLE_SIZE});
+                pending_read.erase(buffer);
+                pending_write.erase(buffer);
+            }
+
+            if (!buffer_memory_barrier.empty()) {
+                VkDependencyInfo dependency_info{
+                        .sType = VK_STRUCTURE_TYPE_DEPENDENCY_INFO,
+                        .bufferMemoryBarrierCount = static_cast<uint32_t>(buffer_memory_barrier.size()),
+                        .pBufferMemoryBarriers = buffer_memory_barrier.data()};
+                vkCmdPipelineBarrier2(commandBuffer, &dependency_info);
+            }
+
+            for (const size_t node: batch) {
+                _compute_job.Dispatch(commandBuffer, _nodes[node].kernel, _nodes[node].group);
+            }
+
+            pending_read.insert(batch_read.begin(), batch_read.end());
+            pending_write.insert(batch_write.begin(), batch_write.end());
+        }
+    }
+
+    std::vector<std::vector<size_t>> ComputeGraph::GetBatches() const {
+        // A node runs one batch after the latest earlier node it conflicts with
+        std::vector<size_t> node_batch(_nodes.size(), 0);
+        size_t batch_count = 0;
+        for (size_t after = 0; after < _nodes.size(); ++after) {
+            for (size_t before = 0; before < after; ++before) {
+                if (HasHazard(_nodes[before], _nodes[after])) {
+                    node_batch[after] = std::max(node_batch[after], node_batch[before] + 1);
+                }
+            }
+            batch_count = std::max(batch_count, node_batch[after] + 1);
+        }
+
+        std::vector<std::vector<size_t>> batches(batch_count);
+        for (size_t node = 0; node < _nodes.size(); ++node) {
+            batches[node_batch[node]].push_back(node);
+        }
+        return batches;
+    }
+
+    bool ComputeGraph::Contains(const std::vector<size_t> &buffers, const size_t buffer) {
+        return std::ranges::find(buffers, buffer) != buffers.end();
+    }
+
+    bool ComputeGraph::HasHazard(const Node &before, const Node &after) {
+        for (const size_t buffer: before.write) {
+            if (Contains(after.read, buffer) || Contains(after.write, buffer)) {
+                return true;
+            }
+        }
+        for (const size_t buffer: before.read) {
+            if (Contains(after.write, buffer)) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+} // namespace Vkxel
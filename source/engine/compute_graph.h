@@ -0,0 +1,51 @@
+//
+// Created by jiayi on 10/19/2026.
+//
+
+#ifndef VKXEL_COMPUTE_GRAPH_H
+#define VKXEL_COMPUTE_GRAPH_H
+
+#include <vector>
+
+#include "glm/glm.hpp"
+#include "vulkan/vulkan_core.h"
+
+namespace Vkxel {
+
+    class ComputeJob;
+
+    // Kernels of one ComputeJob declaring the buffers they access, recorded in batches of independent nodes with
+    // one barrier between batches that only covers buffers with a hazard
+    class ComputeGraph {
+    public:
+        // Buffers are ComputeJob buffer indices, a written buffer may also be read by the same node,
+        // buffers only written by host before the submission do not need to be declared
+        struct Node {
+            size_t kernel;
+            glm::uvec3 group;
+            std::vector<size_t> read = {};
+            std::vector<size_t> write = {};
+        };
+
+        explicit ComputeGraph(ComputeJob &computeJob) : _compute_job(computeJob) {}
+
+        // Nodes keep the order they are added in whenever they touch the same buffer
+        ComputeGraph &AddNode(const Node &node);
+        ComputeGraph &AddNode(const std::vector<Node> &nodes);
+
+        void Record(VkCommandBuffer commandBuffer) const;
+
+        // Node indices grouped by batch, nodes in the same batch have no hazard between them
+        std::vector<std::vector<size_t>> GetBatches() const;
+
+    private:
+        static bool Contains(const std::vector<size_t> &buffers, size_t buffer);
+        static bool HasHazard(const Node &before, const Node &after);
+
+        ComputeJob &_compute_job;
+        std::vector<Node> _nodes = {};
+    };
+
+} // namespace Vkxel
+
+#endif // VKXEL_COMPUTE_GRAPH_H
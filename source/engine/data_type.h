@@ -5,6 +5,7 @@
 #ifndef VKXEL_DATA_TYPE_H
 #define VKXEL_DATA_TYPE_H
 
+#include <optional>
 #include <variant>
 #include <vector>
 
@@ -55,10 +56,17 @@ namespace Vkxel {
     };
 
     struct GPUMeshData {
+        // With indirect arguments these are capacities, the actual count is read by the GPU at draw time
         uint32_t indexCount = 0;
         uint32_t vertexCount = 0;
         VkUtil::Buffer index;
         VkUtil::Buffer vertex;
+        // VkDrawIndexedIndirectCommand at offset 0
+        std::optional<VkUtil::Buffer> indirect = std::nullopt;
+        // Timeline value the producer signals when the buffers are written, draws wait for it on device,
+        // the buffers are drawn in place so the producer must not destroy them while frames are in flight
+        VkSemaphore semaphore = nullptr;
+        uint64_t semaphoreValue = 0;
     };
 
     using MeshData = std::variant<CPUMeshData, GPUMeshData>;
@@ -0,0 +1,33 @@
+//
+// Created by jiayi on 10/19/2026.
+//
+
+#include <mutex>
+#include <string_view>
+#include <vector>
+
+#include "frame_statistics.h"
+
+namespace Vkxel {
+
+    void MesherStatistics::AddTriangles(const std::string_view mesher, const uint64_t triangleCount) {
+        std::scoped_lock lock(_mutex);
+        if (const auto it = _triangles.find(mesher); it != _triangles.end()) {
+            it->second += triangleCount;
+        } else {
+            _triangles.emplace(mesher, triangleCount);
+        }
+    }
+
+    std::vector<MesherTriangles> MesherStatistics::Take() {
+        std::scoped_lock lock(_mutex);
+        std::vector<MesherTriangles> triangles;
+        triangles.reserve(_triangles.size());
+        for (const auto &[mesher, triangle_count]: _triangles) {
+            triangles.push_back({.name = mesher, .triangleCount = triangle_count});
+        }
+        _triangles.clear();
+        return triangles;
+    }
+
+} // namespace Vkxel
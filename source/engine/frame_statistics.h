@@ -0,0 +1,66 @@
+//
+// Created by jiayi on 10/19/2026.
+//
+
+#ifndef VKXEL_FRAME_STATISTICS_H
+#define VKXEL_FRAME_STATISTICS_H
+
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace Vkxel {
+
+    struct MesherTriangles {
+        std::string name;
+        uint64_t triangleCount = 0;
+    };
+
+    // Counters of one rendered frame, complete once the frame resource is reused so they trail by the frames
+    // in flight, plain fields so automated runs can serialize them directly
+    struct FrameStatistics {
+        uint64_t frame = 0;
+
+        // Graphics pipeline statistics of the color pass, zero without the pipelineStatisticsQuery feature
+        bool hasPipelineStatistics = false;
+        uint64_t inputAssemblyVertices = 0;
+        uint64_t inputAssemblyPrimitives = 0;
+        uint64_t vertexShaderInvocations = 0;
+        uint64_t clippingInvocations = 0;
+        uint64_t clippingPrimitives = 0;
+        uint64_t fragmentShaderInvocations = 0;
+
+        uint32_t drawCalls = 0;
+        uint32_t pipelineBinds = 0;
+        uint32_t descriptorSetBinds = 0;
+
+        // CPU meshes staged by ResourceUploader and their bytes, GPU meshes are drawn in place and not counted
+        uint32_t uploadedObjects = 0;
+        uint64_t uploadedHostBytes = 0;
+
+        // Triangles each mesher reported since the previous frame
+        std::vector<MesherTriangles> mesher = {};
+    };
+
+    // Meshers may run before the renderer exists, so their counts are collected here until the next frame
+    class MesherStatistics {
+    public:
+        MesherStatistics() = delete;
+        ~MesherStatistics() = delete;
+
+        static void AddTriangles(std::string_view mesher, uint64_t triangleCount);
+        // Counts since the last call sorted by mesher name
+        static std::vector<MesherTriangles> Take();
+
+    private:
+        inline static std::mutex _mutex;
+        inline static std::map<std::string, uint64_t, std::less<>> _triangles = {};
+    };
+
+} // namespace Vkxel
+
+#endif // VKXEL_FRAME_STATISTICS_H
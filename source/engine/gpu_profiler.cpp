@@ -0,0 +1,289 @@
+//
+// Created by jiayi on 10/19/2026.
+//
+
+#include <algorithm>
+#include <cmath>
+#include <format>
+#include <mutex>
+#include <numeric>
+#include <ranges>
+#include <string>
+#include <string_view>
+#include <tuple>
+#include <vector>
+
+#include "imgui.h"
+#include "rfl/json.hpp"
+
+#include "engine/file.h"
+#include "gpu_profiler.h"
+#include "util/check.h"
+#include "util/debug.hpp"
+
+namespace Vkxel {
+
+    namespace {
+        // Field names follow the Chrome trace event format
+        struct ChromeTraceEvent {
+            std::string name;
+            std::string ph;
+            double ts;
+            double dur;
+            uint32_t pid;
+            uint32_t tid;
+        };
+
+        struct ChromeTrace {
+            std::vector<ChromeTraceEvent> traceEvents;
+        };
+    } // namespace
+
+    GpuProfiler::Scope::Scope(const VkCommandBuffer commandBuffer, const std::string_view name,
+                              const uint32_t queueFamily) : _command_buffer(commandBuffer) {
+        std::tie(_query_pool, _query) = Instance().BeginZone(commandBuffer, name, queueFamily);
+    }
+
+    GpuProfiler::Scope::~Scope() { EndZone(_command_buffer, _query_pool, _query); }
+
+    GpuProfiler &GpuProfiler::Instance() {
+        static GpuProfiler instance;
+        return instance;
+    }
+
+    void GpuProfiler::Init(const VkPhysicalDevice physicalDevice, const VkDevice device) {
+        std::scoped_lock lock(_mutex);
+        CHECK(!_device, "GPU Profiler Already Initialized");
+
+        _device = device;
+
+        VkPhysicalDeviceProperties physical_device_properties;
+        vkGetPhysicalDeviceProperties(physicalDevice, &physical_device_properties);
+        _timestamp_period = physical_device_properties.limits.timestampPeriod;
+
+        uint32_t queue_family_count = 0;
+        vkGetPhysicalDeviceQueueFamilyProperties(physicalDevice, &queue_family_count, nullptr);
+        std::vector<VkQueueFamilyProperties> queue_family_properties(queue_family_count);
+        vkGetPhysicalDeviceQueueFamilyProperties(physicalDevice, &queue_family_count, queue_family_properties.data());
+        _timestamp_valid_bits.resize(queue_family_count);
+        std::ranges::transform(queue_family_properties, _timestamp_valid_bits.begin(),
+                               &VkQueueFamilyProperties::timestampValidBits);
+
+        VkQueryPoolCreateInfo query_pool_create_info{.sType = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO,
+                                                     .queryType = VK_QUERY_TYPE_TIMESTAMP,
+                                                     .queryCount = MaxZonesPerFrame * 2};
+        for (auto &frame: _frame_query) {
+            CHECK_RESULT_VK(vkCreateQueryPool(_device, &query_pool_create_info, nullptr, &frame.queryPool));
+            vkResetQueryPool(_device, frame.queryPool, 0, query_pool_create_info.queryCount);
+        }
+    }
+
+    void GpuProfiler::Destroy() {
+        std::scoped_lock lock(_mutex);
+        if (!_device) {
+            return;
+        }
+
+        for (auto &frame: _frame_query) {
+            vkDestroyQueryPool(_device, frame.queryPool, nullptr);
+            frame = {};
+        }
+        _device = nullptr;
+    }
+
+    void GpuProfiler::BeginFrame() {
+        std::scoped_lock lock(_mutex);
+        if (!_device) {
+            return;
+        }
+
+        _active_frame = (_active_frame + 1) % FrameLatency;
+        FrameQuery &frame = _frame_query[_active_frame];
+        if (frame.queryCount == 0) {
+            return;
+        }
+
+        if (Resolve(frame) || ++frame.pendingFrames > MaxPendingFrames) {
+            vkResetQueryPool(_device, frame.queryPool, 0, frame.queryCount);
+            frame.queryCount = 0;
+            frame.zones.clear();
+            frame.pendingFrames = 0;
+        }
+    }
+
+    bool GpuProfiler::IsEnabled() const {
+        std::scoped_lock lock(_mutex);
+        return _enabled;
+    }
+
+    void GpuProfiler::SetEnabled(const bool enabled) {
+        std::scoped_lock lock(_mutex);
+        _enabled = enabled;
+    }
+
+    void GpuProfiler::Reset() {
+        std::scoped_lock lock(_mutex);
+        _history.clear();
+        _trace.clear();
+    }
+
+    std::vector<GpuProfileEntry> GpuProfiler::GetReport() const {
+        std::vector<GpuProfileEntry> report;
+        {
+            std::scoped_lock lock(_mutex);
+            report.reserve(_history.size());
+            for (const auto &[name, history]: _history) {
+                if (history.empty()) {
+                    continue;
+                }
+
+                std::vector<double> sorted(history.begin(), history.end());
+                std::ranges::sort(sorted);
+                const size_t p99_index =
+                        static_cast<size_t>(std::ceil(0.99 * static_cast<double>(sorted.size()))) - 1;
+
+                report.push_back({.name = name,
+                                  .sampleCount = history.size(),
+                                  .averageMilliseconds = std::accumulate(sorted.begin(), sorted.end(), 0.0) /
+                                                         static_cast<double>(sorted.size()),
+                                  .p99Milliseconds = sorted[p99_index],
+                                  .lastMilliseconds = history.back()});
+            }
+        }
+
+        std::ranges::sort(report, std::ranges::greater{}, &GpuProfileEntry::averageMilliseconds);
+        return report;
+    }
+
+    std::optional<double> GpuProfiler::GetLastMilliseconds(const std::string_view name) const {
+        std::scoped_lock lock(_mutex);
+        auto history = _history.find(std::string(name));
+        if (history == _history.end() || history->second.empty()) {
+            return std::nullopt;
+        }
+        return history->second.back();
+    }
+
+    std::string GpuProfiler::GetChromeTraceJson() const {
+        ChromeTrace trace;
+        {
+            std::scoped_lock lock(_mutex);
+            trace.traceEvents.reserve(_trace.size());
+            for (const auto &[name, queue_family, begin, duration]: _trace) {
+                trace.traceEvents.push_back(
+                        {.name = name, .ph = "X", .ts = begin, .dur = duration, .pid = 0, .tid = queue_family});
+            }
+        }
+        return rfl::json::write(trace);
+    }
+
+    void GpuProfiler::DumpChromeTrace(const std::string_view filePath) const {
+        File::WriteTextFile(filePath, GetChromeTraceJson());
+        Debug::LogInfo("GPU Trace Dumped To {}", filePath);
+    }
+
+    void GpuProfiler::OnGUI() {
+        bool enabled = IsEnabled();
+        if (ImGui::Checkbox("Profile GPU", &enabled)) {
+            SetEnabled(enabled);
+        }
+        ImGui::SameLine();
+        if (ImGui::SmallButton("Reset##GPU")) {
+            Reset();
+        }
+        ImGui::SameLine();
+        if (ImGui::SmallButton("Dump Chrome Trace")) {
+            DumpChromeTrace(_dump_file_path);
+        }
+
+        const auto report = GetReport();
+        if (report.empty()) {
+            return;
+        }
+
+        if (ImGui::BeginTable("GPU Profile", 4, ImGuiTableFlags_Borders | ImGuiTableFlags_RowBg)) {
+            ImGui::TableSetupColumn("Zone");
+            ImGui::TableSetupColumn("Average (ms)");
+            ImGui::TableSetupColumn("P99 (ms)");
+            ImGui::TableSetupColumn("Samples");
+            ImGui::TableHeadersRow();
+
+            for (const auto &entry: report) {
+                ImGui::TableNextRow();
+                ImGui::TableNextColumn();
+                // Zone names may contain user object names, so nothing is passed as a format string
+                ImGui::TextUnformatted(entry.name.c_str());
+                ImGui::TableNextColumn();
+                ImGui::TextUnformatted(std::format("{0:.3f}", entry.averageMilliseconds).c_str());
+                ImGui::TableNextColumn();
+                ImGui::TextUnformatted(std::format("{0:.3f}", entry.p99Milliseconds).c_str());
+                ImGui::TableNextColumn();
+                ImGui::TextUnformatted(std::format("{0}", entry.sampleCount).c_str());
+            }
+            ImGui::EndTable();
+        }
+    }
+
+    std::pair<VkQueryPool, uint32_t> GpuProfiler::BeginZone(const VkCommandBuffer commandBuffer,
+                                                            const std::string_view name, const uint32_t queueFamily) {
+        std::scoped_lock lock(_mutex);
+
+        FrameQuery &frame = _frame_query[_active_frame];
+        if (!_enabled || !_device || queueFamily >= _timestamp_valid_bits.size() ||
+            _timestamp_valid_bits[queueFamily] == 0 || frame.pendingFrames > 0 ||
+            frame.queryCount + 2 > MaxZonesPerFrame * 2) {
+            return {nullptr, InvalidQuery};
+        }
+
+        const uint32_t query = frame.queryCount;
+        frame.queryCount += 2;
+        frame.zones.push_back({.name = std::string(name), .queueFamily = queueFamily, .query = query});
+
+        vkCmdWriteTimestamp2(commandBuffer, VK_PIPELINE_STAGE_2_ALL_COMMANDS_BIT, frame.queryPool, query);
+        return {frame.queryPool, query};
+    }
+
+    void GpuProfiler::EndZone(const VkCommandBuffer commandBuffer, const VkQueryPool queryPool, const uint32_t query) {
+        if (query != InvalidQuery) {
+            vkCmdWriteTimestamp2(commandBuffer, VK_PIPELINE_STAGE_2_ALL_COMMANDS_BIT, queryPool, query + 1);
+        }
+    }
+
+    bool GpuProfiler::Resolve(FrameQuery &frame) {
+        // Timestamp and availability of every query
+        std::vector<uint64_t> result(frame.queryCount * 2);
+        const VkResult query_result =
+                vkGetQueryPoolResults(_device, frame.queryPool, 0, frame.queryCount, result.size() * sizeof(uint64_t),
+                                      result.data(), 2 * sizeof(uint64_t),
+                                      VK_QUERY_RESULT_64_BIT | VK_QUERY_RESULT_WITH_AVAILABILITY_BIT);
+        if (query_result == VK_NOT_READY) {
+            return false;
+        }
+        CHECK_RESULT_VK(query_result);
+
+        for (const auto &[name, queue_family, query]: frame.zones) {
+            const uint64_t mask = _timestamp_valid_bits[queue_family] >= 64
+                                          ? std::numeric_limits<uint64_t>::max()
+                                          : (uint64_t{1} << _timestamp_valid_bits[queue_family]) - 1;
+            const uint64_t begin = result[query * 2] & mask;
+            const uint64_t end = result[(query + 1) * 2] & mask;
+            const double duration_nanoseconds = static_cast<double>((end - begin) & mask) * _timestamp_period;
+
+            std::deque<double> &history = _history[name];
+            history.push_back(duration_nanoseconds * 1e-6);
+            if (history.size() > HistorySize) {
+                history.pop_front();
+            }
+
+            _trace.push_back({.name = name,
+                              .queueFamily = queue_family,
+                              .beginMicroseconds = static_cast<double>(begin) * _timestamp_period * 1e-3,
+                              .durationMicroseconds = duration_nanoseconds * 1e-3});
+            if (_trace.size() > TraceCapacity) {
+                _trace.pop_front();
+            }
+        }
+        return true;
+    }
+
+} // namespace Vkxel
@@ -0,0 +1,132 @@
+//
+// Created by jiayi on 10/19/2026.
+//
+
+#ifndef VKXEL_GPU_PROFILER_H
+#define VKXEL_GPU_PROFILER_H
+
+#include <array>
+#include <cstdint>
+#include <deque>
+#include <limits>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "vulkan/vulkan.h"
+
+namespace Vkxel {
+
+    struct GpuProfileEntry {
+        std::string name;
+        uint64_t sampleCount = 0;
+        double averageMilliseconds = 0;
+        double p99Milliseconds = 0;
+        double lastMilliseconds = 0;
+    };
+
+    // Timestamp query zones recorded into any command buffer, each frame writes into its own query pool which is
+    // read back without waiting FrameLatency frames later, once the GPU is done with it
+    class GpuProfiler {
+    public:
+        // Timestamps around the commands recorded during its lifetime, dropped when the profiler is disabled,
+        // the queue family has no timestamp support or the frame ran out of queries
+        class Scope {
+        public:
+            Scope(VkCommandBuffer commandBuffer, std::string_view name, uint32_t queueFamily);
+            ~Scope();
+
+            Scope(const Scope &) = delete;
+            Scope &operator=(const Scope &) = delete;
+
+        private:
+            VkCommandBuffer _command_buffer = nullptr;
+            VkQueryPool _query_pool = nullptr;
+            uint32_t _query = 0;
+        };
+
+        static constexpr uint32_t FrameLatency = 4;
+        static constexpr uint32_t MaxZonesPerFrame = 256;
+        // Samples kept per zone for the average and p99
+        static constexpr size_t HistorySize = 240;
+        static constexpr size_t TraceCapacity = 16384;
+
+        static GpuProfiler &Instance();
+
+        void Init(VkPhysicalDevice physicalDevice, VkDevice device);
+        void Destroy();
+
+        // Called once per frame before recording, reads back the oldest frame and reuses its query pool
+        void BeginFrame();
+
+        bool IsEnabled() const;
+        void SetEnabled(bool enabled);
+        void Reset();
+
+        // Sorted by average in descending order
+        std::vector<GpuProfileEntry> GetReport() const;
+        // Latest resolved sample of a zone, empty until one was read back
+        std::optional<double> GetLastMilliseconds(std::string_view name) const;
+        // Chrome trace event format, one thread per queue family
+        std::string GetChromeTraceJson() const;
+        void DumpChromeTrace(std::string_view filePath) const;
+
+        void OnGUI();
+
+    private:
+        GpuProfiler() = default;
+
+        static constexpr uint32_t InvalidQuery = std::numeric_limits<uint32_t>::max();
+        // Frames a pool waits for unavailable queries, e.g. from a command buffer that was never submitted,
+        // before its zones are dropped
+        static constexpr uint32_t MaxPendingFrames = 64;
+
+        struct Zone {
+            std::string name;
+            uint32_t queueFamily;
+            uint32_t query;
+        };
+
+        struct FrameQuery {
+            VkQueryPool queryPool = nullptr;
+            uint32_t queryCount = 0;
+            std::vector<Zone> zones = {};
+            uint32_t pendingFrames = 0;
+        };
+
+        struct TraceEvent {
+            std::string name;
+            uint32_t queueFamily;
+            double beginMicroseconds;
+            double durationMicroseconds;
+        };
+
+        // Query pool and index of the begin timestamp, end is the next query
+        std::pair<VkQueryPool, uint32_t> BeginZone(VkCommandBuffer commandBuffer, std::string_view name,
+                                                   uint32_t queueFamily);
+        static void EndZone(VkCommandBuffer commandBuffer, VkQueryPool queryPool, uint32_t query);
+        // False while some queries of the frame are still unavailable
+        bool Resolve(FrameQuery &frame);
+
+        bool _enabled = true;
+        VkDevice _device = nullptr;
+        double _timestamp_period = 0;
+        std::vector<uint32_t> _timestamp_valid_bits = {};
+
+        std::array<FrameQuery, FrameLatency> _frame_query = {};
+        size_t _active_frame = 0;
+
+        mutable std::mutex _mutex;
+        std::unordered_map<std::string, std::deque<double>> _history;
+        std::deque<TraceEvent> _trace;
+
+        std::string _dump_file_path = "./gpu_trace.json";
+    };
+
+} // namespace Vkxel
+
+#endif // VKXEL_GPU_PROFILER_H
@@ -0,0 +1,94 @@
+//
+// Created by jiayi on 10/19/2026.
+//
+
+#include <algorithm>
+#include <cstring>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "file.h"
+#include "pipeline_cache.h"
+#include "shader.h"
+#include "util/check.h"
+#include "util/debug.hpp"
+
+namespace Vkxel {
+
+    PipelineCache &PipelineCache::Instance() {
+        static PipelineCache instance;
+        return instance;
+    }
+
+    void PipelineCache::Init(const VkPhysicalDevice physicalDevice, const VkDevice device) {
+        CHECK(!_pipeline_cache, "Pipeline Cache Already Initialized");
+
+        _device = device;
+        vkGetPhysicalDeviceProperties(physicalDevice, &_physical_device_properties);
+
+        if (_cache_file.empty()) {
+            _cache_file = ShaderLoader::Instance().GetResourceFolder() + _cache_file_name;
+        }
+
+        std::vector<uint8_t> cache_data;
+        if (File::Exist(_cache_file)) {
+            cache_data = File::ReadBinaryFile(_cache_file);
+            if (!IsCompatible(cache_data)) {
+                Debug::LogWarning("Pipeline Cache Discarded, Written By Another Device Or Driver: {}", _cache_file);
+                cache_data.clear();
+            }
+        }
+
+        VkPipelineCacheCreateInfo pipeline_cache_create_info{.sType = VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO,
+                                                             .initialDataSize = cache_data.size(),
+                                                             .pInitialData = cache_data.data()};
+        CHECK_RESULT_VK(vkCreatePipelineCache(_device, &pipeline_cache_create_info, nullptr, &_pipeline_cache));
+
+        Debug::Log("Pipeline Cache Loaded {} Bytes From {}", cache_data.size(), _cache_file);
+    }
+
+    void PipelineCache::Save() const {
+        if (!_pipeline_cache) {
+            return;
+        }
+
+        size_t data_size = 0;
+        CHECK_RESULT_VK(vkGetPipelineCacheData(_device, _pipeline_cache, &data_size, nullptr));
+        std::vector<uint8_t> cache_data(data_size);
+        CHECK_RESULT_VK(vkGetPipelineCacheData(_device, _pipeline_cache, &data_size, cache_data.data()));
+        cache_data.resize(data_size);
+
+        File::WriteBinaryFile(_cache_file, cache_data);
+    }
+
+    void PipelineCache::Destroy() {
+        if (!_pipeline_cache) {
+            return;
+        }
+
+        Save();
+        vkDestroyPipelineCache(_device, _pipeline_cache, nullptr);
+        _pipeline_cache = nullptr;
+        _device = nullptr;
+    }
+
+    VkPipelineCache PipelineCache::Get() const { return _pipeline_cache; }
+
+    void PipelineCache::SetCacheFile(const std::string_view cacheFile) { _cache_file = cacheFile; }
+
+    bool PipelineCache::IsCompatible(const std::vector<uint8_t> &data) const {
+        // Drivers reject foreign data too, checking the header first keeps a stale file from ever reaching them
+        VkPipelineCacheHeaderVersionOne header{};
+        if (data.size() < sizeof(header)) {
+            return false;
+        }
+        std::memcpy(&header, data.data(), sizeof(header));
+
+        return header.headerSize >= sizeof(header) && header.headerVersion == VK_PIPELINE_CACHE_HEADER_VERSION_ONE &&
+               header.vendorID == _physical_device_properties.vendorID &&
+               header.deviceID == _physical_device_properties.deviceID &&
+               std::ranges::equal(header.pipelineCacheUUID, _physical_device_properties.pipelineCacheUUID);
+    }
+
+} // namespace Vkxel
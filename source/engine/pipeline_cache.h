@@ -0,0 +1,49 @@
+//
+// Created by jiayi on 10/19/2026.
+//
+
+#ifndef VKXEL_PIPELINE_CACHE_H
+#define VKXEL_PIPELINE_CACHE_H
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "vulkan/vulkan.h"
+
+namespace Vkxel {
+
+    // Engine wide VkPipelineCache kept in a file next to the SPIR-V cache, so pipelines compiled by an earlier
+    // launch or an earlier re-init skip driver compilation
+    class PipelineCache {
+    public:
+        static PipelineCache &Instance();
+
+        // Load the cache file if it was written by the same driver and device, otherwise start empty
+        void Init(VkPhysicalDevice physicalDevice, VkDevice device);
+        // Write the cache file, called by Destroy
+        void Save() const;
+        void Destroy();
+
+        // Null before Init, pipeline creation then falls back to no cache
+        VkPipelineCache Get() const;
+
+        void SetCacheFile(std::string_view cacheFile);
+
+    private:
+        PipelineCache() = default;
+
+        bool IsCompatible(const std::vector<uint8_t> &data) const;
+
+        const std::string _cache_file_name = "pipeline.cache";
+        std::string _cache_file = {};
+
+        VkDevice _device = nullptr;
+        VkPhysicalDeviceProperties _physical_device_properties = {};
+        VkPipelineCache _pipeline_cache = nullptr;
+    };
+
+} // namespace Vkxel
+
+#endif // VKXEL_PIPELINE_CACHE_H
@@ -2,7 +2,9 @@
 // Created by jiayi on 1/18/2025.
 //
 
+#include <algorithm>
 #include <array>
+#include <optional>
 #include <ranges>
 #include <utility>
 #include <vector>
@@ -13,6 +15,8 @@
 #include "vulkan/vulkan.h"
 
 #include "data_type.h"
+#include "gpu_profiler.h"
+#include "pipeline_cache.h"
 #include "renderer.h"
 #include "resource.h"
 #include "shader.h"
@@ -21,6 +25,7 @@
 #include "vkutil/buffer.h"
 #include "vkutil/command.h"
 #include "vkutil/image.h"
+#include "vkutil/memory.h"
 #include "vkutil/pipeline.h"
 
 
@@ -55,13 +60,17 @@ namespace Vkxel {
         auto physical_device_result =
                 physical_device_selector.prefer_gpu_device_type(vkb::PreferredDeviceType::discrete)
                         .set_surface(_surface)
-                        .set_required_features_12({.scalarBlockLayout = VK_TRUE})
+                        .set_required_features_12({.scalarBlockLayout = VK_TRUE,
+                                                   .hostQueryReset = VK_TRUE,
+                                                   .timelineSemaphore = VK_TRUE})
                         .set_required_features_13({.synchronization2 = VK_TRUE,
                                                    .dynamicRendering = VK_TRUE,
                                                    .shaderIntegerDotProduct = VK_TRUE})
                         .select();
         CHECK(physical_device_result, physical_device_result.error().message());
         _physical_device = physical_device_result.value();
+        const bool memory_budget = _physical_device.enable_extension_if_present(VK_EXT_MEMORY_BUDGET_EXTENSION_NAME);
+        _pipeline_statistics = _physical_device.enable_features_if_present({.pipelineStatisticsQuery = VK_TRUE});
 
         // Create Device
         vkb::DeviceBuilder device_builder(_physical_device);
@@ -99,6 +108,14 @@ namespace Vkxel {
         _transfer_queue = transfer_queue_result.value();
         _transfer_queue_family_index = _device.get_queue_index(vkb::QueueType::transfer).value();
 
+        // Create Frame Timeline Semaphore
+        VkSemaphoreTypeCreateInfo semaphore_type_create_info{.sType = VK_STRUCTURE_TYPE_SEMAPHORE_TYPE_CREATE_INFO,
+                                                             .semaphoreType = VK_SEMAPHORE_TYPE_TIMELINE,
+                                                             .initialValue = 0};
+        VkSemaphoreCreateInfo semaphore_create_info{.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO,
+                                                    .pNext = &semaphore_type_create_info};
+        CHECK_RESULT_VK(vkCreateSemaphore(_device, &semaphore_create_info, nullptr, &_frame_timeline_semaphore));
+
         // Create Command Pool
         VkCommandPoolCreateInfo command_pool_create_info{.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO,
                                                          .flags = VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT,
@@ -145,8 +162,45 @@ namespace Vkxel {
 
         CHECK_RESULT_VK(vkCreateDescriptorPool(_device, &descriptor_pool_create_info, nullptr, &_descriptor_pool));
 
+        // Create Descriptor Allocator
+        _frame_descriptor_allocator = std::make_unique<VkUtil::DescriptorAllocator>(
+                _device, static_cast<uint32_t>(_frame_resource.size()),
+                std::vector<VkUtil::DescriptorAllocator::PoolSizeRatio>{{VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, 1.0f}});
+        _object_descriptor_allocator = std::make_unique<VkUtil::DescriptorAllocator>(
+                _device, Application::DefaultDescriptorSetsPerPool,
+                std::vector<VkUtil::DescriptorAllocator::PoolSizeRatio>{{VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, 1.0f}},
+                VK_DESCRIPTOR_POOL_CREATE_FREE_DESCRIPTOR_SET_BIT);
+        // Compute jobs bind up to 8 storage buffers
+        _compute_descriptor_allocator = std::make_unique<VkUtil::DescriptorAllocator>(
+                _device, Application::DefaultDescriptorSetsPerPool,
+                std::vector<VkUtil::DescriptorAllocator::PoolSizeRatio>{{VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 8.0f}},
+                VK_DESCRIPTOR_POOL_CREATE_FREE_DESCRIPTOR_SET_BIT);
+
+        // Create Pipeline Registry
+        _pipeline_registry = std::make_unique<VkUtil::PipelineRegistry>(_device);
+
+        // Create Statistics Query Pool
+        if (_pipeline_statistics) {
+            VkQueryPoolCreateInfo query_pool_create_info{
+                    .sType = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO,
+                    .queryType = VK_QUERY_TYPE_PIPELINE_STATISTICS,
+                    .queryCount = 1,
+                    .pipelineStatistics = VK_QUERY_PIPELINE_STATISTIC_INPUT_ASSEMBLY_VERTICES_BIT |
+                                          VK_QUERY_PIPELINE_STATISTIC_INPUT_ASSEMBLY_PRIMITIVES_BIT |
+                                          VK_QUERY_PIPELINE_STATISTIC_VERTEX_SHADER_INVOCATIONS_BIT |
+                                          VK_QUERY_PIPELINE_STATISTIC_CLIPPING_INVOCATIONS_BIT |
+                                          VK_QUERY_PIPELINE_STATISTIC_CLIPPING_PRIMITIVES_BIT |
+                                          VK_QUERY_PIPELINE_STATISTIC_FRAGMENT_SHADER_INVOCATIONS_BIT};
+            for (auto &query_pool: _statistics_query_pool) {
+                CHECK_RESULT_VK(vkCreateQueryPool(_device, &query_pool_create_info, nullptr, &query_pool));
+                vkResetQueryPool(_device, query_pool, 0, 1);
+            }
+        }
+
         // Create VMA Allocator
+        // Without the memory budget extension VMA estimates budgets from its own allocations
         VmaAllocatorCreateInfo vma_allocator_create_info{
+                .flags = memory_budget ? VMA_ALLOCATOR_CREATE_EXT_MEMORY_BUDGET_BIT : 0u,
                 .physicalDevice = _physical_device,
                 .device = _device,
                 .instance = _instance,
@@ -154,6 +208,10 @@ namespace Vkxel {
 
         CHECK_RESULT_VK(vmaCreateAllocator(&vma_allocator_create_info, &_allocator));
 
+        // Create Pipeline Cache
+        PipelineCache::Instance().Init(_physical_device, _device);
+        GpuProfiler::Instance().Init(_physical_device, _device);
+
         // Create GUI
         GuiInitInfo gui_init_info{.Instance = _instance,
                                   .PhysicalDevice = _physical_device,
@@ -177,8 +235,20 @@ namespace Vkxel {
 
         _gui.DestroyVK();
 
+        GpuProfiler::Instance().Destroy();
+        _pipeline_registry->Destroy();
+        PipelineCache::Instance().Destroy();
         vmaDestroyAllocator(_allocator);
+        _compute_descriptor_allocator->Destroy();
+        _object_descriptor_allocator->Destroy();
+        _frame_descriptor_allocator->Destroy();
+        for (auto &query_pool: _statistics_query_pool) {
+            vkDestroyQueryPool(_device, query_pool, nullptr);
+            query_pool = nullptr;
+        }
         vkDestroyDescriptorPool(_device, _descriptor_pool, nullptr);
+        vkDestroySemaphore(_device, _frame_timeline_semaphore, nullptr);
+        _frame_timeline_semaphore = nullptr;
         vkDestroyCommandPool(_device, _transfer_command_pool, nullptr);
         vkDestroyCommandPool(_device, _compute_command_pool, nullptr);
         vkDestroyCommandPool(_device, _command_pool, nullptr);
@@ -216,9 +286,9 @@ namespace Vkxel {
                                                     &_descriptor_set_layout_object));
 
         // Upload Data
-        _resource_manager = std::make_unique<ResourceManager>(_device, _queue_family_index, _command_pool,
-                                                              _descriptor_pool, _descriptor_set_layout_frame,
-                                                              _descriptor_set_layout_object, _allocator);
+        _resource_manager = std::make_unique<ResourceManager>(
+                _device, _queue_family_index, _command_pool, *_frame_descriptor_allocator,
+                *_object_descriptor_allocator, _descriptor_set_layout_frame, _descriptor_set_layout_object, _allocator);
         _resource_uploader = std::make_unique<ResourceUploader>(_device, _transfer_queue_family_index, _transfer_queue,
                                                                 _transfer_command_pool, _allocator);
 
@@ -237,7 +307,7 @@ namespace Vkxel {
         // _resource_uploader->Upload();
 
         // Create Graphics Pipeline
-        _pipeline = VkUtil::DefaultGraphicsPipelineBuilder(_device).Build(
+        _pipeline = VkUtil::DefaultGraphicsPipelineBuilder(_device, _pipeline_registry.get()).Build(
                 {_descriptor_set_layout_frame, _descriptor_set_layout_object});
     }
 
@@ -251,10 +321,14 @@ namespace Vkxel {
             _resource_manager->DestroyObjectResource(object);
         }
         _object_resource.clear();
+        _object_descriptor_allocator->Flush();
 
         for (auto &resource: _frame_resource) {
             _resource_manager->DestroyFrameResource(resource);
         }
+        _frame_descriptor_allocator->Reset();
+
+        _resource_uploader.reset();
 
         vkDestroyDescriptorSetLayout(_device, _descriptor_set_layout_frame, nullptr);
         vkDestroyDescriptorSetLayout(_device, _descriptor_set_layout_object, nullptr);
@@ -286,6 +360,15 @@ namespace Vkxel {
 
         vkResetCommandBuffer(frame.commandBuffer, 0);
 
+        VkUtil::MemoryStatistics::CheckBudget(_allocator);
+        GpuProfiler::Instance().BeginFrame();
+
+        ResolveFrameStatistics(_active_frame_resource_index);
+        FrameStatistics &statistics = _in_flight_frame_statistics[_active_frame_resource_index];
+        statistics = {.frame = ++_frame_count,
+                      .hasPipelineStatistics = _pipeline_statistics,
+                      .mesher = MesherStatistics::Take()};
+
         _context = {};
         _scene.value().get().Draw(_context);
 
@@ -334,9 +417,9 @@ namespace Vkxel {
         }
         _resource_manager->UpdateFrameResource(frame.commandBuffer, _context.scene, frame);
 
-        // Upload Object Mesh Data (Block Wait)
-        // TODO Support Async Upload
+        // Upload Object Mesh Data
         _resource_uploader->Upload();
+        _resource_uploader->AddStatistics(statistics);
 
         frame.colorImage.CmdBarrier(frame.commandBuffer, VK_PIPELINE_STAGE_2_TOP_OF_PIPE_BIT, VK_ACCESS_2_NONE,
                                     VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT,
@@ -367,10 +450,16 @@ namespace Vkxel {
                                        .pStencilAttachment = nullptr};
 
         VkDeviceSize offset_zero = 0;
+        std::optional<GpuProfiler::Scope> zone(std::in_place, frame.commandBuffer, "Color Pass", _queue_family_index);
+        if (statistics.hasPipelineStatistics) {
+            vkCmdBeginQuery(frame.commandBuffer, _statistics_query_pool[_active_frame_resource_index], 0, 0);
+        }
         vkCmdBeginRendering(frame.commandBuffer, &rendering_info); // Camera Pass
         vkCmdBindPipeline(frame.commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, _pipeline.pipeline);
         vkCmdBindDescriptorSets(frame.commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, _pipeline.layout, 0, 1,
                                 &frame.descriptorSet.set, 0, nullptr);
+        ++statistics.pipelineBinds;
+        ++statistics.descriptorSetBinds;
 
         for (const auto &object: _object_resource | std::views::values) {
             if (object.isActive) {
@@ -378,11 +467,22 @@ namespace Vkxel {
                                         &object.descriptorSet.set, 0, nullptr);
                 vkCmdBindIndexBuffer(frame.commandBuffer, object.indexBuffer.buffer, offset_zero, VK_INDEX_TYPE_UINT32);
                 vkCmdBindVertexBuffers(frame.commandBuffer, 0, 1, &object.vertexBuffer.buffer, &offset_zero);
-                vkCmdDrawIndexed(frame.commandBuffer, object.indexCount, 1, object.firstIndex, 0, 0);
+                if (object.indirectBuffer) {
+                    vkCmdDrawIndexedIndirect(frame.commandBuffer, object.indirectBuffer->buffer, 0, 1,
+                                             sizeof(VkDrawIndexedIndirectCommand));
+                } else {
+                    vkCmdDrawIndexed(frame.commandBuffer, object.indexCount, 1, object.firstIndex, 0, 0);
+                }
+                ++statistics.descriptorSetBinds;
+                ++statistics.drawCalls;
             }
         }
 
         vkCmdEndRendering(frame.commandBuffer);
+        if (statistics.hasPipelineStatistics) {
+            vkCmdEndQuery(frame.commandBuffer, _statistics_query_pool[_active_frame_resource_index], 0);
+        }
+        zone.reset();
 
         // UI Pass
         frame.colorImage.CmdBarrier(frame.commandBuffer, VK_PIPELINE_STAGE_2_COLOR_ATTACHMENT_OUTPUT_BIT,
@@ -405,9 +505,11 @@ namespace Vkxel {
                                           .pDepthAttachment = nullptr,
                                           .pStencilAttachment = nullptr};
 
+        zone.emplace(frame.commandBuffer, "UI Pass", _queue_family_index);
         vkCmdBeginRendering(frame.commandBuffer, &rendering_info_ui);
         _gui.Render(frame.commandBuffer);
         vkCmdEndRendering(frame.commandBuffer);
+        zone.reset();
 
         frame.colorImage.CmdBarrier(frame.commandBuffer, VK_PIPELINE_STAGE_2_COLOR_ATTACHMENT_OUTPUT_BIT,
                                     VK_ACCESS_2_COLOR_ATTACHMENT_READ_BIT | VK_ACCESS_2_COLOR_ATTACHMENT_WRITE_BIT,
@@ -468,7 +570,9 @@ namespace Vkxel {
                                    .pRegions = &blit_region,
                                    .filter = VK_FILTER_LINEAR};
 
+        zone.emplace(frame.commandBuffer, "Blit", _queue_family_index);
         vkCmdBlitImage2(frame.commandBuffer, &blit_info);
+        zone.reset();
 
         present_image_memory_barrier.srcStageMask = VK_PIPELINE_STAGE_2_BLIT_BIT;
         present_image_memory_barrier.srcAccessMask = VK_ACCESS_2_TRANSFER_WRITE_BIT;
@@ -483,22 +587,47 @@ namespace Vkxel {
 
         VkCommandBufferSubmitInfo command_buffer_submit_info{.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_SUBMIT_INFO,
                                                              .commandBuffer = frame.commandBuffer};
-        VkSemaphoreSubmitInfo image_ready_semaphore_submit_info{.sType = VK_STRUCTURE_TYPE_SEMAPHORE_SUBMIT_INFO,
-                                                                .semaphore = frame.imageReadySemaphore,
-                                                                .stageMask = VK_PIPELINE_STAGE_2_BLIT_BIT};
+        std::vector<VkSemaphoreSubmitInfo> wait_semaphore_submit_infos{
+                {.sType = VK_STRUCTURE_TYPE_SEMAPHORE_SUBMIT_INFO,
+                 .semaphore = frame.imageReadySemaphore,
+                 .stageMask = VK_PIPELINE_STAGE_2_BLIT_BIT}};
+
+        // GPU meshes are drawn from the producer buffers, wait for the latest value of each producer on device
+        for (const auto &object: _object_resource | std::views::values) {
+            if (!object.isActive || !object.waitSemaphore) {
+                continue;
+            }
+            auto it = std::ranges::find(wait_semaphore_submit_infos, object.waitSemaphore,
+                                        &VkSemaphoreSubmitInfo::semaphore);
+            if (it == wait_semaphore_submit_infos.end()) {
+                wait_semaphore_submit_infos.push_back(
+                        {.sType = VK_STRUCTURE_TYPE_SEMAPHORE_SUBMIT_INFO,
+                         .semaphore = object.waitSemaphore,
+                         .value = object.waitSemaphoreValue,
+                         .stageMask = VK_PIPELINE_STAGE_2_DRAW_INDIRECT_BIT |
+                                      VK_PIPELINE_STAGE_2_VERTEX_INPUT_BIT});
+            } else {
+                it->value = std::max(it->value, object.waitSemaphoreValue);
+            }
+        }
 
-        VkSemaphoreSubmitInfo render_complete_semaphore_submit_info{.sType = VK_STRUCTURE_TYPE_SEMAPHORE_SUBMIT_INFO,
-                                                                    .semaphore = frame.renderCompleteSemaphore,
-                                                                    .stageMask =
-                                                                            VK_PIPELINE_STAGE_2_BOTTOM_OF_PIPE_BIT};
+        std::array signal_semaphore_submit_infos{
+                VkSemaphoreSubmitInfo{.sType = VK_STRUCTURE_TYPE_SEMAPHORE_SUBMIT_INFO,
+                                      .semaphore = frame.renderCompleteSemaphore,
+                                      .stageMask = VK_PIPELINE_STAGE_2_BOTTOM_OF_PIPE_BIT},
+                VkSemaphoreSubmitInfo{.sType = VK_STRUCTURE_TYPE_SEMAPHORE_SUBMIT_INFO,
+                                      .semaphore = _frame_timeline_semaphore,
+                                      .value = _frame_count,
+                                      .stageMask = VK_PIPELINE_STAGE_2_ALL_COMMANDS_BIT}};
 
         VkSubmitInfo2 submit_info{.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO_2,
-                                  .waitSemaphoreInfoCount = 1,
-                                  .pWaitSemaphoreInfos = &image_ready_semaphore_submit_info,
+                                  .waitSemaphoreInfoCount = static_cast<uint32_t>(wait_semaphore_submit_infos.size()),
+                                  .pWaitSemaphoreInfos = wait_semaphore_submit_infos.data(),
                                   .commandBufferInfoCount = 1,
                                   .pCommandBufferInfos = &command_buffer_submit_info,
-                                  .signalSemaphoreInfoCount = 1,
-                                  .pSignalSemaphoreInfos = &render_complete_semaphore_submit_info};
+                                  .signalSemaphoreInfoCount =
+                                          static_cast<uint32_t>(signal_semaphore_submit_infos.size()),
+                                  .pSignalSemaphoreInfos = signal_semaphore_submit_infos.data()};
         vkQueueSubmit2(_queue, 1, &submit_info, frame.commandFence);
 
 
@@ -513,6 +642,7 @@ namespace Vkxel {
         CHECK_RESULT_VK(vkQueuePresentKHR(_queue, &present_info));
 
         // Release Outdated Object Resource
+        _object_descriptor_allocator->Flush();
         for (auto it = _object_resource.begin(); it != _object_resource.end();) {
             if (auto &[object_id, object_resource] = *it; !object_resource.isActive) {
                 Timer::ExecuteAfterTicks(_frame_resource.size(), [&, object_resource]() mutable {
@@ -549,6 +679,9 @@ namespace Vkxel {
 
         for (auto &resource: _frame_resource) {
             _resource_manager->DestroyFrameResource(resource);
+        }
+        _frame_descriptor_allocator->Reset();
+        for (auto &resource: _frame_resource) {
             resource = _resource_manager->CreateFrameResource(_swapchain.extent.width, _swapchain.extent.height);
         }
     }
@@ -557,10 +690,51 @@ namespace Vkxel {
 
 
     ComputeJob Renderer::CreateComputeJob() {
-        return {_device,   _compute_queue_family_index, _compute_queue, _compute_command_pool, _descriptor_pool,
-                _allocator};
+        // Meshes generated on the compute queue are drawn directly by the graphics queue
+        return {_device,
+                _compute_queue_family_index,
+                _compute_queue,
+                _compute_command_pool,
+                *_compute_descriptor_allocator,
+                *_pipeline_registry,
+                _allocator,
+                _queue_family_index};
+    }
+
+    VkSemaphore Renderer::GetFrameTimelineSemaphore() const { return _frame_timeline_semaphore; }
+
+    uint64_t Renderer::GetSubmittedFrameValue() const { return _frame_count; }
+
+
+    const FrameStatistics &Renderer::GetFrameStatistics() const { return _frame_statistics; }
+
+    void Renderer::ResolveFrameStatistics(const size_t frameResourceIndex) {
+        FrameStatistics &statistics = _in_flight_frame_statistics[frameResourceIndex];
+        if (statistics.frame == 0) {
+            return;
+        }
+
+        if (statistics.hasPipelineStatistics) {
+            // In the order of the enabled VkQueryPipelineStatisticFlagBits, the fence is signaled so nothing waits
+            std::array<uint64_t, 6> result = {};
+            const VkQueryPool query_pool = _statistics_query_pool[frameResourceIndex];
+            CHECK_RESULT_VK(vkGetQueryPoolResults(_device, query_pool, 0, 1, sizeof(result), result.data(),
+                                                  sizeof(result), VK_QUERY_RESULT_64_BIT | VK_QUERY_RESULT_WAIT_BIT));
+            vkResetQueryPool(_device, query_pool, 0, 1);
+
+            statistics.inputAssemblyVertices = result[0];
+            statistics.inputAssemblyPrimitives = result[1];
+            statistics.vertexShaderInvocations = result[2];
+            statistics.clippingInvocations = result[3];
+            statistics.clippingPrimitives = result[4];
+            statistics.fragmentShaderInvocations = result[5];
+        }
+
+        _frame_statistics = std::move(statistics);
+        statistics = {};
     }
 
+    VmaAllocator Renderer::GetAllocator() const { return _allocator; }
 
     Window &Renderer::GetWindow() const { return _window; }
 
@@ -15,10 +15,13 @@
 #include "vulkan/vulkan.h"
 
 #include "compute.h"
+#include "frame_statistics.h"
 #include "gui.h"
 #include "resource.h"
 #include "resource_type.h"
+#include "vkutil/descriptor.h"
 #include "vkutil/pipeline.h"
+#include "vkutil/pipeline_registry.h"
 #include "window.h"
 #include "world/scene.h"
 
@@ -44,10 +47,22 @@ namespace Vkxel {
 
         ComputeJob CreateComputeJob();
 
+        // Signaled with the frame number when the graphics queue finishes a frame,
+        // buffers drawn by frames up to GetSubmittedFrameValue are free once it is reached
+        VkSemaphore GetFrameTimelineSemaphore() const;
+        uint64_t GetSubmittedFrameValue() const;
+
+        // Counters of the latest frame the GPU has finished
+        const FrameStatistics &GetFrameStatistics() const;
+
+        VmaAllocator GetAllocator() const;
         Window &GetWindow() const;
         GUI &GetGUI() const;
 
     private:
+        // Read back the statistics of a frame resource whose fence has been waited
+        void ResolveFrameStatistics(size_t frameResourceIndex);
+
         Window &_window;
         GUI &_gui;
 
@@ -70,6 +85,7 @@ namespace Vkxel {
         VkSurfaceKHR _surface = nullptr;
         VkQueue _queue = nullptr;
         VkCommandPool _command_pool = nullptr;
+        // Only used by the GUI, engine descriptor sets come from the allocators below
         VkDescriptorPool _descriptor_pool = nullptr;
         uint32_t _queue_family_index = 0;
 
@@ -83,6 +99,13 @@ namespace Vkxel {
 
         // Resource Related Handle
 
+        // Frame sets are released together, object and compute sets are freed one by one in batches
+        std::unique_ptr<VkUtil::DescriptorAllocator> _frame_descriptor_allocator;
+        std::unique_ptr<VkUtil::DescriptorAllocator> _object_descriptor_allocator;
+        std::unique_ptr<VkUtil::DescriptorAllocator> _compute_descriptor_allocator;
+
+        // Layouts and pipelines shared by identical requests, compute jobs of the same shader reuse one set
+        std::unique_ptr<VkUtil::PipelineRegistry> _pipeline_registry;
         VkUtil::GraphicsPipeline _pipeline = {};
 
         std::unique_ptr<ResourceManager> _resource_manager;
@@ -93,6 +116,14 @@ namespace Vkxel {
         std::array<FrameResource, 2> _frame_resource = {};
         size_t _active_frame_resource_index = 0;
 
+        // Frame Statistics
+        bool _pipeline_statistics = false;
+        std::array<VkQueryPool, 2> _statistics_query_pool = {};
+        std::array<FrameStatistics, 2> _in_flight_frame_statistics = {};
+        FrameStatistics _frame_statistics = {};
+        uint64_t _frame_count = 0;
+        VkSemaphore _frame_timeline_semaphore = nullptr;
+
         // Object Resources
         VkDescriptorSetLayout _descriptor_set_layout_object = nullptr;
         std::unordered_map<IdType, ObjectResource> _object_resource;
@@ -3,6 +3,7 @@
 //
 
 #include <array>
+#include <bit>
 #include <list>
 #include <ranges>
 #include <vector>
@@ -21,6 +22,9 @@ namespace Vkxel {
     }
 
     void ResourceUploader::UploadObjects() {
+        _uploaded_objects = 0;
+        _uploaded_host_bytes = 0;
+
         if (_objects.empty()) {
             return;
         }
@@ -32,26 +36,37 @@ namespace Vkxel {
                 const auto &[index, vertex] = std::get<CPUMeshData>(object.mesh);
                 total_size += sizeof(IndexType) * index.size();
                 total_size += sizeof(VertexType) * vertex.size();
+                // GPU meshes are drawn in place, only meshes staged here count as uploaded
+                ++_uploaded_objects;
                 // total_size += sizeof(ConstantBufferPerObject);
             }
         }
 
         if (total_size > 0) {
-            VkUtil::Buffer staging_buffer =
-                    VkUtil::BufferBuilder(_device, _allocator)
-                            .SetSize(total_size)
-                            .SetUsage(VK_BUFFER_USAGE_TRANSFER_SRC_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT)
-                            .SetPQueueFamilyIndices(&_queue_family)
-                            .SetAllocationFlags(VMA_ALLOCATION_CREATE_HOST_ACCESS_SEQUENTIAL_WRITE_BIT)
-                            .SetMemoryUsage(VMA_MEMORY_USAGE_AUTO_PREFER_HOST)
-                            .SetRequiredFlags(VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT)
-                            .Build();
-            staging_buffer.Create();
+            // The staging buffer is kept mapped between uploads and only grows
+            if (!_staging_buffer.buffer || _staging_buffer.createInfo.size < total_size) {
+                if (_staging_buffer.buffer) {
+                    _staging_buffer.Destroy();
+                }
+                _staging_buffer =
+                        VkUtil::BufferBuilder(_device, _allocator)
+                                .SetSize(std::bit_ceil(total_size))
+                                .SetUsage(VK_BUFFER_USAGE_TRANSFER_SRC_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT)
+                                .SetPQueueFamilyIndices(&_queue_family)
+                                .SetAllocationFlags(VMA_ALLOCATION_CREATE_HOST_ACCESS_SEQUENTIAL_WRITE_BIT)
+                                .SetMemoryUsage(VMA_MEMORY_USAGE_AUTO_PREFER_HOST)
+                                .SetRequiredFlags(VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT)
+                                .SetPersistentMapped()
+                                .SetCategory(VkUtil::MemoryCategory::Staging)
+                                .Build();
+                _staging_buffer.Create();
+            }
 
-            std::byte *host_buffer = staging_buffer.Map();
+            VkUtil::Buffer &staging_buffer = _staging_buffer;
+            std::byte *host_buffer = staging_buffer.GetMappedData();
             VkDeviceSize host_buffer_offset = 0;
 
-            VkUtil::ImmediateCommand immediate_command(_device, _queue, _command_pool);
+            VkUtil::ImmediateCommand immediate_command(_immediate_command_pool);
             VkCommandBuffer command_buffer = immediate_command.Begin();
 
             for (const auto &[object_wrapper, resource_wrapper]: _objects) {
@@ -96,64 +111,58 @@ namespace Vkxel {
                 // host_buffer_offset += static_cast<uint32_t>(resource.constantBuffer.createInfo.size);
             }
 
-            staging_buffer.Flush();
+            staging_buffer.Flush(0, host_buffer_offset);
+            _uploaded_host_bytes = host_buffer_offset;
 
+            // CPU meshes are only uploaded when they change, waiting keeps the staging buffer free for the next one
             immediate_command.End();
-
-            staging_buffer.Unmap();
-            staging_buffer.Destroy();
         }
 
-        VkUtil::ImmediateCommand immediate_command(_device, _queue, _command_pool);
-        VkCommandBuffer command_buffer = immediate_command.Begin();
+        // GPU meshes are drawn in place from the producer buffers, so they have nothing to upload
+        _objects.clear();
+    }
 
-        for (const auto &[object_wrapper, resource_wrapper]: _objects) {
-            const ObjectData &object = object_wrapper;
-            const ObjectResource &resource = resource_wrapper;
+    void ResourceUploader::Upload() { UploadObjects(); }
 
-            if (std::holds_alternative<GPUMeshData>(object.mesh)) {
-                const auto &[index_count, vertex_count, index, vertex] = std::get<GPUMeshData>(object.mesh);
+    void ResourceUploader::AddStatistics(FrameStatistics &statistics) const {
+        statistics.uploadedObjects += _uploaded_objects;
+        statistics.uploadedHostBytes += _uploaded_host_bytes;
+    }
 
-                VkBufferCopy index_copy_region{.srcOffset = 0, .dstOffset = 0, .size = index_count * sizeof(IndexType)};
-                vkCmdCopyBuffer(command_buffer, index.buffer, resource.indexBuffer.buffer, 1, &index_copy_region);
+    ResourceUploader::~ResourceUploader() {
+        VkUtil::MemoryStatistics::RemoveBudgetCallback(_budget_callback);
+        _immediate_command_pool.Destroy();
+        ReleaseStagingBuffer();
+    }
 
-                VkBufferCopy vertex_copy_region{
-                        .srcOffset = 0, .dstOffset = 0, .size = vertex_count * sizeof(VertexType)};
-                vkCmdCopyBuffer(command_buffer, vertex.buffer, resource.vertexBuffer.buffer, 1, &vertex_copy_region);
-            }
+    void ResourceUploader::ReleaseStagingBuffer() {
+        if (_staging_buffer.buffer) {
+            _staging_buffer.Destroy();
+            _staging_buffer = {};
         }
-
-        immediate_command.End();
-
-        _objects.clear();
     }
 
-    void ResourceUploader::Upload() { UploadObjects(); }
-
 
     ObjectResource ResourceManager::CreateObjectResource(const ObjectData &object) {
 
         ObjectResource resource = {.isActive = true, .firstIndex = 0};
 
         VkUtil::BufferBuilder buffer_builder(_device, _allocator);
-        buffer_builder.SetMemoryUsage(VMA_MEMORY_USAGE_AUTO_PREFER_DEVICE).SetPQueueFamilyIndices(&_queue_family);
+        buffer_builder.SetMemoryUsage(VMA_MEMORY_USAGE_AUTO_PREFER_DEVICE)
+                .SetPQueueFamilyIndices(&_queue_family)
+                .SetCategory(VkUtil::MemoryCategory::Mesh);
 
         if (std::holds_alternative<GPUMeshData>(object.mesh)) {
-            const auto &[index_count, vertex_count, index, vertex] = std::get<GPUMeshData>(object.mesh);
+            const auto &[index_count, vertex_count, index, vertex, indirect, semaphore, semaphore_value] =
+                    std::get<GPUMeshData>(object.mesh);
 
-            resource.indexBuffer =
-                    VkUtil::BufferBuilder(index)
-                            .SetSize(index_count * sizeof(IndexType))
-                            .SetUsage(VK_BUFFER_USAGE_INDEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT)
-                            .Build();
-            resource.indexBuffer.Create();
-
-            resource.vertexBuffer =
-                    VkUtil::BufferBuilder(vertex)
-                            .SetSize(vertex_count * sizeof(VertexType))
-                            .SetUsage(VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT)
-                            .Build();
-            resource.vertexBuffer.Create();
+            // Drawn straight from the producer buffers once its semaphore is signaled, nothing is copied
+            resource.indexBuffer = index;
+            resource.vertexBuffer = vertex;
+            resource.indirectBuffer = indirect;
+            resource.externalMesh = true;
+            resource.waitSemaphore = semaphore;
+            resource.waitSemaphoreValue = semaphore_value;
 
             resource.indexCount = index_count;
         } else if (std::holds_alternative<CPUMeshData>(object.mesh)) {
@@ -188,7 +197,8 @@ namespace Vkxel {
 
         // Create DescriptorSet
         resource.descriptorSet =
-                VkUtil::DescriptorSetBuilder(_device, _descriptor_pool, _descriptor_set_layout_object).Build();
+                VkUtil::DescriptorSetBuilder(_device, _object_descriptor_allocator, _descriptor_set_layout_object)
+                        .Build();
         resource.descriptorSet.Create();
 
         VkDescriptorBufferInfo constant_buffer_per_object_info{
@@ -228,8 +238,13 @@ namespace Vkxel {
 
 
     void ResourceManager::DestroyObjectResource(ObjectResource &resource) {
-        resource.indexBuffer.Destroy();
-        resource.vertexBuffer.Destroy();
+        if (!resource.externalMesh) {
+            resource.indexBuffer.Destroy();
+            resource.vertexBuffer.Destroy();
+            if (resource.indirectBuffer) {
+                resource.indirectBuffer->Destroy();
+            }
+        }
         resource.constantBuffer.Destroy();
         resource.descriptorSet.Destroy();
 
@@ -244,6 +259,7 @@ namespace Vkxel {
                                             .SetUsage(VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT)
                                             .SetPQueueFamilyIndices(&_queue_family)
                                             .SetMemoryUsage(VMA_MEMORY_USAGE_AUTO_PREFER_DEVICE)
+                                            .SetCategory(VkUtil::MemoryCategory::FrameTarget)
                                             .SetViewSubresourceRange({.aspectMask = VK_IMAGE_ASPECT_DEPTH_BIT,
                                                                       .baseMipLevel = 0,
                                                                       .levelCount = 1,
@@ -261,6 +277,7 @@ namespace Vkxel {
                         .SetUsage(VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT)
                         .SetPQueueFamilyIndices(&_queue_family)
                         .SetMemoryUsage(VMA_MEMORY_USAGE_AUTO_PREFER_DEVICE)
+                        .SetCategory(VkUtil::MemoryCategory::FrameTarget)
                         .SetViewSubresourceRange({.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT,
                                                   .baseMipLevel = 0,
                                                   .levelCount = 1,
@@ -276,12 +293,14 @@ namespace Vkxel {
                         .SetPQueueFamilyIndices(&_queue_family)
                         .SetSize(sizeof(ConstantBufferPerFrame))
                         .SetUsage(VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT)
+                        .SetCategory(VkUtil::MemoryCategory::FrameTarget)
                         .Build();
         constant_buffer.Create();
 
         // Create Scene DescriptorSet
         VkUtil::DescriptorSet descriptor_set =
-                VkUtil::DescriptorSetBuilder(_device, _descriptor_pool, _descriptor_set_layout_frame).Build();
+                VkUtil::DescriptorSetBuilder(_device, _frame_descriptor_allocator, _descriptor_set_layout_frame)
+                        .Build();
         descriptor_set.Create();
 
         VkDescriptorBufferInfo constant_buffer_per_frame_info{
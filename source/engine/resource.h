@@ -11,7 +11,11 @@
 #include "vulkan/vulkan.h"
 
 #include "data_type.h"
+#include "frame_statistics.h"
 #include "resource_type.h"
+#include "vkutil/command.h"
+#include "vkutil/descriptor.h"
+#include "vkutil/memory.h"
 
 namespace Vkxel {
 
@@ -20,19 +24,36 @@ namespace Vkxel {
         ResourceUploader(const VkDevice device, const uint32_t queueFamily, const VkQueue queue,
                          const VkCommandPool commandPool, const VmaAllocator allocator) :
             _device(device), _queue_family(queueFamily), _queue(queue), _command_pool(commandPool),
-            _allocator(allocator) {}
+            _allocator(allocator), _immediate_command_pool(device, queue, commandPool),
+            _budget_callback(VkUtil::MemoryStatistics::AddBudgetCallback(
+                    [this](uint32_t, float) { ReleaseStagingBuffer(); })) {}
 
         ResourceUploader &AddObject(const ObjectData &object, ObjectResource &resource);
         void UploadObjects();
         void Upload();
 
+        // Add the objects and bytes of the last Upload to statistics
+        void AddStatistics(FrameStatistics &statistics) const;
+
+        ~ResourceUploader();
+
     private:
+        // Uploads wait for their copies, so the staging buffer is idle between them and can be rebuilt on demand
+        void ReleaseStagingBuffer();
+
         VkDevice _device = nullptr;
         uint32_t _queue_family = 0;
         VkQueue _queue = nullptr;
         VkCommandPool _command_pool = nullptr;
         VmaAllocator _allocator = nullptr;
 
+        VkUtil::Buffer _staging_buffer = {};
+        VkUtil::ImmediateCommandPool _immediate_command_pool;
+        uint64_t _budget_callback = 0;
+
+        uint32_t _uploaded_objects = 0;
+        uint64_t _uploaded_host_bytes = 0;
+
         std::vector<std::pair<std::reference_wrapper<const ObjectData>, std::reference_wrapper<ObjectResource>>>
                 _objects;
     };
@@ -40,10 +61,14 @@ namespace Vkxel {
     class ResourceManager {
     public:
         ResourceManager(const VkDevice device, const uint32_t queueFamily, const VkCommandPool commandPool,
-                        const VkDescriptorPool descriptorPool, const VkDescriptorSetLayout descriptorSetLayoutFrame,
+                        VkUtil::DescriptorAllocator &frameDescriptorAllocator,
+                        VkUtil::DescriptorAllocator &objectDescriptorAllocator,
+                        const VkDescriptorSetLayout descriptorSetLayoutFrame,
                         const VkDescriptorSetLayout descriptorSetLayoutObject, const VmaAllocator allocator) :
-            _device(device), _queue_family(queueFamily), _command_pool(commandPool), _descriptor_pool(descriptorPool),
-            _allocator(allocator), _descriptor_set_layout_frame(descriptorSetLayoutFrame),
+            _device(device), _queue_family(queueFamily), _command_pool(commandPool),
+            _frame_descriptor_allocator(frameDescriptorAllocator),
+            _object_descriptor_allocator(objectDescriptorAllocator), _allocator(allocator),
+            _descriptor_set_layout_frame(descriptorSetLayoutFrame),
             _descriptor_set_layout_object(descriptorSetLayoutObject) {}
 
         ObjectResource CreateObjectResource(const ObjectData &object);
@@ -61,7 +86,8 @@ namespace Vkxel {
         VkDevice _device = nullptr;
         uint32_t _queue_family = 0;
         VkCommandPool _command_pool = nullptr;
-        VkDescriptorPool _descriptor_pool = nullptr;
+        VkUtil::DescriptorAllocator &_frame_descriptor_allocator;
+        VkUtil::DescriptorAllocator &_object_descriptor_allocator;
         VmaAllocator _allocator = nullptr;
         VkDescriptorSetLayout _descriptor_set_layout_frame = nullptr;
         VkDescriptorSetLayout _descriptor_set_layout_object = nullptr;
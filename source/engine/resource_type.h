@@ -6,6 +6,7 @@
 #define VKXEL_RESOURCE_TYPE_H
 
 #include <cstdint>
+#include <optional>
 
 #include "vkutil/buffer.h"
 #include "vkutil/descriptor.h"
@@ -20,6 +21,13 @@ namespace Vkxel {
         uint32_t firstIndex = 0;
         VkUtil::Buffer indexBuffer = {};
         VkUtil::Buffer vertexBuffer = {};
+        // Draw with vkCmdDrawIndexedIndirect when present, indexCount is ignored
+        std::optional<VkUtil::Buffer> indirectBuffer = std::nullopt;
+        // Index, vertex and indirect buffers belong to the producer of a GPU mesh and are not destroyed here
+        bool externalMesh = false;
+        // Timeline value the frame waits for before drawing an external mesh
+        VkSemaphore waitSemaphore = nullptr;
+        uint64_t waitSemaphoreValue = 0;
         VkUtil::Buffer constantBuffer = {};
         VkUtil::DescriptorSet descriptorSet = {};
     };
@@ -58,6 +58,16 @@ namespace Vkxel {
         full_path += shader;
         std::string spirv_full_path = full_path + _spirv_extension;
         std::string slang_full_path = full_path + _slang_extension;
+
+        if (auto source = _registered_source.find(std::string(shader)); source != _registered_source.end()) {
+            if (File::Exist(spirv_full_path) && !force_compile) {
+                return LoadSpirv(spirv_full_path);
+            }
+            std::vector<uint8_t> spirv = LoadSlangSource(shader, slang_full_path, source->second);
+            File::WriteBinaryFile(spirv_full_path, spirv);
+            return spirv;
+        }
+
         bool exist_spirv = File::Exist(spirv_full_path);
         bool exist_slang = File::Exist(slang_full_path);
         CHECK(exist_slang, "Shader Not Exist: {}", slang_full_path);
@@ -93,6 +103,26 @@ namespace Vkxel {
         _shader_resource_folder = resource_folder;
     }
 
+    const std::string &ShaderLoader::GetResourceFolder() const { return _shader_resource_folder; }
+
+
+    void ShaderLoader::RegisterSource(const std::string_view shader, const std::string_view source) {
+        _registered_source[std::string(shader)] = source;
+    }
+
+    bool ShaderLoader::HasSource(const std::string_view shader) const {
+        return _registered_source.contains(std::string(shader));
+    }
+
+    void ShaderLoader::UnregisterSource(const std::string_view shader) {
+        if (_registered_source.erase(std::string(shader)) == 0) {
+            return;
+        }
+        std::string spirv_full_path = _shader_resource_folder;
+        spirv_full_path += shader;
+        spirv_full_path += _spirv_extension;
+        std::filesystem::remove(spirv_full_path);
+    }
 
     std::vector<uint8_t> ShaderLoader::LoadSlang(const std::string_view shader_file) {
 
@@ -104,6 +134,26 @@ namespace Vkxel {
             CHECK(module);
         }
 
+        return CompileModule(module);
+    }
+
+    std::vector<uint8_t> ShaderLoader::LoadSlangSource(const std::string_view shader,
+                                                       const std::string_view shader_file,
+                                                       const std::string_view source) {
+
+        Slang::ComPtr<slang::IModule> module;
+        {
+            Slang::ComPtr<slang::IBlob> diagnosticBlob;
+            module = _slang_session->loadModuleFromSourceString(std::string(shader).data(), shader_file.data(),
+                                                                std::string(source).data(), diagnosticBlob.writeRef());
+            CHECK(!diagnosticBlob.get(), static_cast<const char *>(diagnosticBlob.get()->getBufferPointer()));
+            CHECK(module);
+        }
+
+        return CompileModule(module);
+    }
+
+    std::vector<uint8_t> ShaderLoader::CompileModule(slang::IModule *module) {
         Slang::ComPtr<slang::IComponentType> linkedProgram;
         {
             Slang::ComPtr<slang::IBlob> diagnosticBlob;
@@ -8,6 +8,7 @@
 #include <cstdint>
 #include <string>
 #include <string_view>
+#include <unordered_map>
 #include <vector>
 
 #include "slang-com-ptr.h"
@@ -24,17 +25,30 @@ namespace Vkxel {
         VkShaderModule LoadToModule(VkDevice device, std::string_view shader, bool force_compile = false);
         void ClearSpirvCache();
         void SetResourceFolder(std::string_view resource_folder);
+        const std::string &GetResourceFolder() const;
+
+        // Register in-memory Slang source under a shader name, it is compiled as if it were in the resource folder,
+        // so it can import and include shader files, the name should change whenever the source changes
+        void RegisterSource(std::string_view shader, std::string_view source);
+        bool HasSource(std::string_view shader) const;
+        // Forget a registered source and delete its cached spirv once no pipeline will be created from it again
+        void UnregisterSource(std::string_view shader);
 
     private:
         ShaderLoader();
 
         std::vector<uint8_t> LoadSlang(std::string_view shader_file);
+        std::vector<uint8_t> LoadSlangSource(std::string_view shader, std::string_view shader_file,
+                                             std::string_view source);
+        std::vector<uint8_t> CompileModule(slang::IModule *module);
         std::vector<uint8_t> LoadSpirv(std::string_view shader_file);
 
         const std::string _spirv_extension = ".spirv";
         const std::string _slang_extension = ".slang";
         std::string _shader_resource_folder = "./shader/";
 
+        std::unordered_map<std::string, std::string> _registered_source;
+
         Slang::ComPtr<slang::IGlobalSession> _slang_global_session;
         Slang::ComPtr<slang::ISession> _slang_session;
     };
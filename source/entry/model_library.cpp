@@ -2,8 +2,14 @@
 // Created by jiayi on 1/21/2025.
 //
 
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <variant>
+
 #include "glm/glm.hpp"
 
+#include "custom/mesh_sdf.h"
 #include "engine/data_type.h"
 #include "model_library.h"
 
@@ -147,6 +153,194 @@ namespace Vkxel {
                glm::dot(f02, glm::vec4(-.01, .06, -.02, .07)) + glm::dot(f03, glm::vec4(-.05, .07, .03, .04)) - 0.16f;
     };
 
+    // Batched StanfordBunnySDF, same network with the four 4x4 blocks of each layer fused into one 16x16 matrix
+    namespace {
+        // Input layer, sin(dot(weight.xyz, p) + weight.w)
+        constexpr float bunny_input_weight[16][4] = {
+                {0.29f, -3.02f, 3.08f, -0.71f},
+                {-1.16f, 1.95f, 0.85f, 4.50f},
+                {3.74f, -3.42f, -2.25f, -3.24f},
+                {-2.89f, -0.60f, -0.24f, -3.50f},
+                {-2.90f, -0.40f, -0.36f, 7.02f},
+                {0.54f, -3.61f, 3.64f, -5.41f},
+                {2.75f, 3.23f, -3.91f, -1.12f},
+                {-2.71f, -0.14f, 2.66f, -7.41f},
+                {-3.15f, -1.77f, -3.49f, -2.07f},
+                {-2.14f, -1.28f, -2.81f, 4.49f},
+                {3.85f, -4.29f, -0.64f, 5.33f},
+                {-1.83f, -3.20f, 2.79f, -2.17f},
+                {2.65f, -0.49f, -2.87f, -3.24f},
+                {-0.33f, 0.68f, 0.78f, -5.90f},
+                {-0.07f, 3.05f, 3.78f, 1.14f},
+                {0.64f, 0.42f, -3.41f, -4.71f},
+        };
+        constexpr float bunny_hidden0_weight[16][16] = {
+                {-0.34f, 0.10f, 0.64f, -0.16f, 0.01f, 0.06f, -0.18f, 0.33f,
+                 0.27f, 0.18f, -0.14f, -0.13f, -0.13f, 1.13f, -0.32f, 0.14f},
+                {0.06f, -0.19f, -0.02f, 0.21f, 0.54f, -0.14f, 0.08f, -0.49f,
+                 0.22f, -0.17f, 0.02f, -0.06f, 0.29f, 0.02f, 0.04f, -0.03f},
+                {-0.59f, -0.12f, -0.26f, 0.91f, -0.77f, 0.43f, 0.39f, -0.10f,
+                 0.43f, 0.23f, -0.10f, -0.04f, -0.29f, -0.83f, -0.31f, -0.20f},
+                {-0.76f, 0.44f, 0.15f, 0.15f, 0.11f, 0.51f, 0.20f, 0.19f,
+                 0.53f, -0.64f, 0.16f, -0.36f, 0.08f, 0.32f, -0.16f, 0.39f},
+                {-1.11f, 0.16f, -0.01f, -0.29f, 0.96f, -0.14f, 0.02f, -0.06f,
+                 0.52f, -0.56f, -0.04f, -0.02f, 0.02f, -0.59f, -0.06f, -0.12f},
+                {0.55f, 0.15f, 0.01f, 0.38f, -0.02f, 0.60f, -0.15f, -0.25f,
+                 0.44f, -0.10f, 0.55f, 0.28f, -0.32f, 0.00f, 0.13f, -0.14f},
+                {-0.12f, -0.30f, 0.31f, -0.04f, 0.86f, 0.44f, -0.49f, -0.03f,
+                 -0.05f, -0.61f, 0.32f, 0.26f, 0.06f, -0.24f, -0.21f, 0.58f},
+                {-1.00f, 0.31f, -0.42f, 0.71f, 0.52f, 0.43f, -0.05f, -0.22f,
+                 -0.11f, -0.40f, -0.07f, -0.49f, -0.17f, 0.60f, -0.27f, -0.55f},
+                {0.44f, 0.05f, 0.35f, 0.40f, -0.48f, 0.11f, -0.25f, 0.32f,
+                 0.39f, -0.38f, 0.48f, 0.00f, 0.46f, 0.72f, 0.90f, -0.16f},
+                {-0.06f, -0.60f, 0.12f, -0.26f, 0.43f, -0.01f, 0.25f, -0.02f,
+                 -0.07f, -0.27f, -0.20f, -0.21f, -0.32f, -0.47f, 0.02f, 0.22f},
+                {-0.79f, 0.30f, 0.02f, 0.63f, -0.73f, 0.71f, -0.28f, -0.84f,
+                 0.90f, -1.86f, -0.05f, 0.29f, 0.06f, 0.81f, -0.21f, 0.32f},
+                {-0.46f, 0.36f, 0.12f, -0.21f, -0.40f, 0.05f, -0.20f, 0.16f,
+                 0.36f, -0.39f, 0.10f, 0.63f, 0.09f, 0.78f, 0.08f, -0.13f},
+                {-0.41f, -0.24f, -0.27f, -0.01f, 0.64f, -0.34f, 0.22f, 0.02f,
+                 0.79f, -1.13f, -0.67f, -0.07f, 0.43f, 1.38f, 0.39f, -0.57f},
+                {-0.24f, -0.75f, -0.42f, 0.51f, 0.31f, 0.11f, -0.16f, -0.37f,
+                 0.47f, -0.35f, -0.26f, -0.73f, -0.23f, -0.63f, -0.14f, -0.08f},
+                {-0.71f, -0.09f, 0.02f, -0.12f, -1.36f, 0.14f, -0.29f, 0.49f,
+                 0.54f, -1.03f, 0.10f, -0.11f, 0.13f, 1.57f, 0.42f, -0.21f},
+                {-0.25f, 0.02f, 0.03f, -1.24f, 0.61f, 0.79f, -0.70f, 0.39f,
+                 -0.47f, -0.22f, 0.21f, 0.72f, 0.09f, -0.20f, 0.13f, 0.21f},
+        };
+        constexpr float bunny_hidden0_bias[16] = {0.73f, -4.28f, -1.56f, -1.80f, -2.24f, -3.48f, -0.80f, 1.41f,
+                                                  3.38f, 1.20f, 0.84f, 1.41f, -0.34f, -3.28f, 0.43f, -0.52f};
+        constexpr float bunny_hidden1_weight[16][16] = {
+                {-0.72f, 0.38f, 0.26f, 0.29f, -0.22f, -0.32f, -0.20f, -0.41f,
+                 -0.21f, 0.05f, 0.13f, 0.01f, -0.13f, 0.48f, -0.34f, -0.44f},
+                {0.23f, 0.19f, -0.37f, -0.72f, -0.51f, 0.00f, -0.03f, 0.09f,
+                 0.01f, 0.20f, 0.12f, -0.34f, -0.06f, 0.25f, 0.14f, 0.05f},
+                {-0.89f, -0.16f, 0.09f, 0.30f, -0.42f, -1.03f, -0.13f, 0.36f,
+                 0.33f, -0.44f, -0.13f, 0.41f, -0.39f, 0.24f, 0.42f, 0.09f},
+                {0.52f, -0.88f, 0.63f, -0.95f, -0.73f, 1.17f, -0.16f, -0.84f,
+                 0.47f, -1.04f, 0.31f, -0.34f, -0.22f, -0.97f, 0.00f, -0.95f},
+                {-0.27f, 0.34f, -1.15f, -0.12f, -1.11f, -0.79f, 0.60f, -0.03f,
+                 -0.92f, 0.58f, -0.80f, 0.08f, 0.29f, -0.91f, 0.21f, 1.10f},
+                {0.29f, -0.23f, -0.24f, -0.73f, 0.35f, -0.03f, -0.37f, -0.21f,
+                 -0.17f, 0.60f, -0.16f, 0.16f, 0.45f, 0.66f, 0.16f, -0.38f},
+                {-0.21f, 0.85f, -0.05f, -0.17f, -0.93f, -0.46f, -0.14f, 0.02f,
+                 -0.58f, 0.83f, 0.23f, 0.76f, 0.30f, -0.35f, -0.54f, 0.20f},
+                {0.15f, -0.09f, -0.25f, -0.37f, -0.06f, -0.37f, 0.45f, 0.59f,
+                 -0.18f, -1.04f, -0.11f, 0.61f, 0.39f, -0.35f, -0.63f, 0.15f},
+                {1.00f, 0.88f, -0.68f, 0.46f, 0.51f, 0.68f, 0.20f, -0.09f,
+                 0.14f, -0.65f, 0.71f, -1.68f, -0.31f, 0.95f, -0.63f, 1.23f},
+                {0.66f, 0.25f, -0.08f, 1.15f, -0.57f, -0.50f, 0.44f, -0.37f,
+                 0.29f, 0.33f, -0.07f, -0.20f, 0.69f, 0.36f, 0.52f, 0.72f},
+                {1.30f, -0.67f, -0.12f, 0.38f, 0.41f, -0.04f, -0.60f, -1.30f,
+                 -0.45f, -0.37f, 1.00f, 0.00f, 0.56f, 0.56f, -0.30f, 0.95f},
+                {-0.51f, 0.03f, -0.14f, -0.10f, -0.09f, -1.01f, 0.46f, 0.04f,
+                 -0.06f, -0.95f, -0.60f, -0.70f, 0.13f, 0.59f, 0.17f, 0.75f},
+                {0.51f, -0.22f, 0.70f, 0.78f, 0.81f, -1.03f, -0.06f, 0.73f,
+                 -0.10f, 0.40f, 0.03f, -0.03f, -0.18f, -0.01f, 0.24f, 0.23f},
+                {-0.98f, -0.17f, -0.15f, 0.67f, 0.60f, -0.33f, 0.01f, 0.69f,
+                 0.52f, -0.75f, 0.05f, 0.22f, -0.07f, 0.56f, 0.25f, -0.08f},
+                {-0.28f, -1.03f, 0.12f, -0.85f, -0.89f, 0.60f, -0.02f, 1.02f,
+                 0.80f, 0.47f, 0.08f, -1.63f, -1.22f, 0.07f, -0.09f, 0.20f},
+                {0.16f, 0.22f, 0.43f, -0.25f, 0.61f, -0.11f, -0.44f, 0.62f,
+                 -0.65f, 1.56f, 0.31f, 0.07f, 0.48f, 0.15f, -0.54f, 0.36f},
+        };
+        constexpr float bunny_hidden1_bias[16] = {0.48f, 0.87f, -0.87f, -2.06f, -1.72f, -0.14f, 1.92f, 2.08f,
+                                                  -0.90f, -3.26f, -0.44f, -3.11f, -1.11f, -4.28f, 1.02f, -0.23f};
+        constexpr float bunny_output_weight[16] = {0.09f, 0.12f, -0.07f, -0.03f, -0.04f, 0.07f, -0.08f, 0.05f,
+                                                   -0.01f, 0.06f, -0.02f, 0.07f, -0.05f, 0.07f, 0.03f, 0.04f};
+
+        // Points evaluated together, every loop over lanes is independent so it compiles to SIMD
+        constexpr uint32_t bunny_lane_count = 8;
+
+        // Range reduced to [-pi/2, pi/2] and approximated by the degree 11 Taylor polynomial,
+        // absolute error is below 1e-6 for the |x| < 40 the bunny network produces
+        inline float BunnySin(const float x) {
+            constexpr float inv_two_pi = 0.159154943f;
+            constexpr float two_pi_hi = 6.28318548f;
+            constexpr float two_pi_lo = -1.74845553e-7f;
+            constexpr float pi = 3.14159274f;
+            constexpr float half_pi = 1.57079637f;
+
+            const float k = std::floor(x * inv_two_pi + 0.5f);
+            float r = (x - k * two_pi_hi) - k * two_pi_lo;
+            r = r > half_pi ? pi - r : (r < -half_pi ? -pi - r : r);
+
+            const float r2 = r * r;
+            return r * (1.0f +
+                        r2 * (-1.66666667e-1f +
+                              r2 * (8.33333333e-3f +
+                                    r2 * (-1.98412698e-4f + r2 * (2.75573192e-6f + r2 * -2.50521084e-8f)))));
+        }
+
+        // out = sin(weight * in + bias) * scale + in
+        inline void BunnyResidualLayer(const float (&weight)[16][16], const float (&bias)[16], const float scale,
+                                       const float (&in)[16][bunny_lane_count], float (&out)[16][bunny_lane_count]) {
+            for (uint32_t row = 0; row < 16; ++row) {
+                float sum[bunny_lane_count];
+                for (uint32_t lane = 0; lane < bunny_lane_count; ++lane) {
+                    sum[lane] = bias[row];
+                }
+                for (uint32_t column = 0; column < 16; ++column) {
+                    const float w = weight[row][column];
+                    for (uint32_t lane = 0; lane < bunny_lane_count; ++lane) {
+                        sum[lane] += w * in[column][lane];
+                    }
+                }
+                for (uint32_t lane = 0; lane < bunny_lane_count; ++lane) {
+                    out[row][lane] = BunnySin(sum[lane]) * scale + in[row][lane];
+                }
+            }
+        }
+
+        void BunnyEvaluateLanes(const glm::vec3 *p, float *value, const uint32_t count) {
+            float x[bunny_lane_count] = {};
+            float y[bunny_lane_count] = {};
+            float z[bunny_lane_count] = {};
+            for (uint32_t lane = 0; lane < count; ++lane) {
+                x[lane] = p[lane].x;
+                y[lane] = p[lane].y;
+                z[lane] = p[lane].z;
+            }
+
+            float h0[16][bunny_lane_count];
+            float h1[16][bunny_lane_count];
+            for (uint32_t row = 0; row < 16; ++row) {
+                const auto &w = bunny_input_weight[row];
+                for (uint32_t lane = 0; lane < bunny_lane_count; ++lane) {
+                    h0[row][lane] = BunnySin(w[0] * x[lane] + w[1] * y[lane] + w[2] * z[lane] + w[3]);
+                }
+            }
+
+            BunnyResidualLayer(bunny_hidden0_weight, bunny_hidden0_bias, 1.0f, h0, h1);
+            BunnyResidualLayer(bunny_hidden1_weight, bunny_hidden1_bias, 1.0f / 1.4f, h1, h0);
+
+            float result[bunny_lane_count];
+            for (uint32_t lane = 0; lane < bunny_lane_count; ++lane) {
+                result[lane] = -0.16f;
+            }
+            for (uint32_t row = 0; row < 16; ++row) {
+                for (uint32_t lane = 0; lane < bunny_lane_count; ++lane) {
+                    result[lane] += bunny_output_weight[row] * h0[row][lane];
+                }
+            }
+
+            // Outside the unit sphere the network is not trained, fall back to a bounding sphere like the scalar
+            for (uint32_t lane = 0; lane < count; ++lane) {
+                const float length = std::sqrt(x[lane] * x[lane] + y[lane] * y[lane] + z[lane] * z[lane]);
+                value[lane] = length > 1.0f ? length - 0.8f : result[lane];
+            }
+        }
+    } // namespace
+
+    // Matches StanfordBunnySDF within 2e-6 inside the unit sphere and exactly outside of it,
+    // the bound is checked by test/bunny_batch_sdf_test.cpp
+    const SDFBatchType ModelLibrary::StanfordBunnyBatchSDF = [](SDFBatchInputType p, SDFBatchOutputType value) {
+        for (size_t index = 0; index < p.size(); index += bunny_lane_count) {
+            const uint32_t count = static_cast<uint32_t>(std::min<size_t>(bunny_lane_count, p.size() - index));
+            BunnyEvaluateLanes(p.data() + index, value.data() + index, count);
+        }
+    };
+
     const MeshData ModelLibrary::TriangleMesh = CPUMeshData{
             .index = {0, 1, 2},
             .vertex = {
@@ -8601,4 +8795,10 @@ namespace Vkxel {
                                glm::vec3{0.96f, 0.42f, 0.43f}},
             }};
 
+    // Padded by a few voxels around the mesh bound so the trilinear sample stays exact around the surface
+    const SDFType ModelLibrary::StanfordBunnyVolumeSDF = [](const glm::vec3 &p) -> float {
+        static const SDFVolume volume = MeshSDFBaker(std::get<CPUMeshData>(StanfordBunnyMesh)).Bake(200.0f, 5);
+        return volume.Sample(p);
+    };
+
 } // namespace Vkxel
@@ -18,6 +18,9 @@ namespace Vkxel {
         ~ModelLibrary() = delete;
 
         static const SDFType StanfordBunnySDF;
+        static const SDFBatchType StanfordBunnyBatchSDF;
+        // StanfordBunnyMesh baked into an SDFVolume on first evaluation
+        static const SDFType StanfordBunnyVolumeSDF;
 
         static const MeshData TriangleMesh;
         static const MeshData StanfordBunnyMesh;
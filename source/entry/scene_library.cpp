@@ -6,6 +6,7 @@
 
 #include "custom/dual_contouring.h"
 #include "custom/gpu_dual_contouring.h"
+#include "custom/sdf_profiler.h"
 #include "model_library.h"
 #include "scene_library.h"
 #include "world/camera.h"
@@ -52,6 +53,12 @@ namespace Vkxel {
             if (ImGui::Button("GPU Generate Mesh")) {
                 gpu_dual_contouring.GenerateMesh();
             }
+            ImGui::Text(std::format("Rebuild {0:.3f} ms", gpu_dual_contouring.GetRebuildMilliseconds()).data());
+            if (const auto dispatch = gpu_dual_contouring.GetDispatchMilliseconds()) {
+                ImGui::Text(std::format("Dispatch {0:.3f} ms (GPU)", dispatch.value()).data());
+            } else {
+                ImGui::Text("Dispatch - (Enable Profile GPU)");
+            }
         };
 
         // Create SDF Object
@@ -79,16 +86,10 @@ namespace Vkxel {
             if (ImGui::Button("Generate Mesh")) {
                 dual_contouring.GenerateMesh();
             }
+            // The profiler covers every SDF tree, so one canvas shows it for all CPU meshers
+            SDFProfiler::Instance().OnGUI();
         };
 
-        // GameObject &sdf_bunny = scene.CreateGameObject();
-        // sdf_bunny.name = "SDF Bunny";
-        // sdf_bunny.transform.SetParent(sdf_object.transform);
-        // sdf_bunny.transform.rotation = glm::radians(glm::vec3{-90, 90, 0});
-        // SDFSurface &sdf_bunny_surface = sdf_bunny.AddComponent<SDFSurface>();
-        // sdf_bunny_surface.surfaceType = SurfaceType::Custom;
-        // sdf_bunny_surface.customSDF = ModelLibrary::StanfordBunnySDF;
-
         GameObject &sdf_box = scene.CreateGameObject();
         sdf_box.name = "SDF Box";
         sdf_box.transform.SetParent(sdf_object.transform);
@@ -122,6 +123,70 @@ namespace Vkxel {
         sdf_capsule_surface.surfaceType = SurfaceType::Primitive;
         sdf_capsule_surface.primitiveType = PrimitiveType::Capsule;
 
+        // Create Bunny SDF Object, meshed through the batched network
+        GameObject &bunny_sdf_object = scene.CreateGameObject();
+        bunny_sdf_object.name = "Bunny SDF Object";
+        bunny_sdf_object.transform.SetParent(root_object.transform);
+        bunny_sdf_object.transform.position = {0, -2.5f, 7};
+        bunny_sdf_object.AddComponent<Mesh>();
+        bunny_sdf_object.AddComponent<Drawer>();
+
+        SDFSurface &bunny_sdf_surface = bunny_sdf_object.AddComponent<SDFSurface>();
+        bunny_sdf_surface.surfaceType = SurfaceType::CSG;
+        bunny_sdf_surface.csgType = CSGType::Unionize;
+
+        DualContouring &bunny_dual_contouring = bunny_sdf_object.AddComponent<DualContouring>();
+        bunny_dual_contouring.minBound = glm::vec3{-1.2f};
+        bunny_dual_contouring.maxBound = glm::vec3{1.2f};
+        bunny_dual_contouring.resolution = 20;
+
+        bunny_sdf_object.AddComponent<Canvas>().uiItems += [&]() {
+            if (ImGui::Button("Generate Bunny Mesh")) {
+                bunny_dual_contouring.GenerateMesh();
+            }
+        };
+
+        GameObject &sdf_bunny = scene.CreateGameObject();
+        sdf_bunny.name = "SDF Bunny";
+        sdf_bunny.transform.SetParent(bunny_sdf_object.transform);
+        sdf_bunny.transform.rotation = glm::radians(glm::vec3{-90, 90, 0});
+        SDFSurface &sdf_bunny_surface = sdf_bunny.AddComponent<SDFSurface>();
+        sdf_bunny_surface.surfaceType = SurfaceType::Custom;
+        sdf_bunny_surface.customSDF = ModelLibrary::StanfordBunnySDF;
+        sdf_bunny_surface.customBatchSDF = ModelLibrary::StanfordBunnyBatchSDF;
+
+        // Create Baked Bunny SDF Object, the bunny mesh turned back into an SDF through MeshSDFBaker
+        GameObject &baked_bunny_object = scene.CreateGameObject();
+        baked_bunny_object.name = "Baked Bunny SDF Object";
+        baked_bunny_object.transform.SetParent(root_object.transform);
+        baked_bunny_object.transform.position = {0, 2.5f, 7};
+        baked_bunny_object.AddComponent<Mesh>();
+        baked_bunny_object.AddComponent<Drawer>();
+
+        SDFSurface &baked_bunny_surface = baked_bunny_object.AddComponent<SDFSurface>();
+        baked_bunny_surface.surfaceType = SurfaceType::CSG;
+        baked_bunny_surface.csgType = CSGType::Unionize;
+
+        DualContouring &baked_bunny_dual_contouring = baked_bunny_object.AddComponent<DualContouring>();
+        baked_bunny_dual_contouring.minBound = glm::vec3{-1.2f};
+        baked_bunny_dual_contouring.maxBound = glm::vec3{1.2f};
+        baked_bunny_dual_contouring.resolution = 32;
+
+        baked_bunny_object.AddComponent<Canvas>().uiItems += [&]() {
+            if (ImGui::Button("Generate Baked Bunny Mesh")) {
+                baked_bunny_dual_contouring.GenerateMesh();
+            }
+        };
+
+        GameObject &baked_bunny = scene.CreateGameObject();
+        baked_bunny.name = "Baked Bunny";
+        baked_bunny.transform.SetParent(baked_bunny_object.transform);
+        baked_bunny.transform.position = {0.13f, -0.88f, 0};
+        baked_bunny.transform.scale = {8, 8, 8};
+        SDFSurface &baked_bunny_volume_surface = baked_bunny.AddComponent<SDFSurface>();
+        baked_bunny_volume_surface.surfaceType = SurfaceType::Custom;
+        baked_bunny_volume_surface.customSDF = ModelLibrary::StanfordBunnyVolumeSDF;
+
         GameObject &bunny_root = scene.CreateGameObject();
         bunny_root.name = "Bunny Root";
         bunny_root.transform.SetParent(root_object.transform);
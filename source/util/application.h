@@ -38,6 +38,7 @@ namespace Vkxel {
 
         static constexpr uint32_t DefaultDescriptorCount = 1000;
         static constexpr uint32_t DefaultDescriptorSetCount = 1000;
+        static constexpr uint32_t DefaultDescriptorSetsPerPool = 64;
 
         static constexpr float DefaultMoveSpeed = 1.0f;
         static constexpr float DefaultRotateSpeed = 1.0f;
@@ -0,0 +1,52 @@
+//
+// Created by jiayi on 10/19/2026.
+//
+
+#ifndef VKXEL_HASH_H
+#define VKXEL_HASH_H
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <string_view>
+#include <type_traits>
+
+namespace Vkxel {
+
+    // FNV-1a over raw bytes, stable across runs so it can key on-disk caches
+    class Hash {
+    public:
+        Hash() = delete;
+        ~Hash() = delete;
+
+        static constexpr uint64_t Seed = 14695981039346656037ull;
+
+        static uint64_t Bytes(const void *data, const size_t size, uint64_t seed = Seed) {
+            const auto *bytes = static_cast<const uint8_t *>(data);
+            for (size_t index = 0; index < size; ++index) {
+                seed ^= bytes[index];
+                seed *= 1099511628211ull;
+            }
+            return seed;
+        }
+
+        template<typename T>
+            requires std::is_trivially_copyable_v<T>
+        static uint64_t Value(const T &value, const uint64_t seed = Seed) {
+            return Bytes(&value, sizeof(T), seed);
+        }
+
+        template<typename T>
+            requires std::is_trivially_copyable_v<T>
+        static uint64_t Span(std::span<const T> value, const uint64_t seed = Seed) {
+            return Bytes(value.data(), value.size_bytes(), seed);
+        }
+
+        static uint64_t String(const std::string_view value, const uint64_t seed = Seed) {
+            return Bytes(value.data(), value.size(), seed);
+        }
+    };
+
+} // namespace Vkxel
+
+#endif // VKXEL_HASH_H
@@ -6,6 +6,7 @@
 #include "vulkan/vulkan.h"
 
 #include "buffer.h"
+#include "memory.h"
 #include "util/check.h"
 
 namespace Vkxel::VkUtil {
@@ -13,6 +14,9 @@ namespace Vkxel::VkUtil {
     void Buffer::Create() {
         CHECK_RESULT_VK(
                 vmaCreateBuffer(allocator, &createInfo, &allocationCreateInfo, &buffer, &allocation, &allocationInfo));
+        vmaGetAllocationMemoryProperties(allocator, allocation, &memoryPropertyFlags);
+        vmaSetAllocationName(allocator, allocation, GetMemoryCategoryName(category).data());
+        MemoryStatistics::Track(category, allocationInfo.size);
 
         if (viewCreateInfo.sType == VK_STRUCTURE_TYPE_BUFFER_VIEW_CREATE_INFO) {
             viewCreateInfo.buffer = buffer;
@@ -24,32 +28,57 @@ namespace Vkxel::VkUtil {
         if (bufferView) {
             vkDestroyBufferView(device, bufferView, nullptr);
         }
+        if (allocation) {
+            MemoryStatistics::Untrack(category, allocationInfo.size);
+        }
         vmaDestroyBuffer(allocator, buffer, allocation);
     }
 
     std::byte *Buffer::Map() {
+        if (std::byte *mapped_data = GetMappedData()) {
+            return mapped_data;
+        }
         std::byte *memory;
         CHECK_RESULT_VK(vmaMapMemory(allocator, allocation, reinterpret_cast<void **>(&memory)));
         return memory;
     }
 
-    void Buffer::Unmap() { vmaUnmapMemory(allocator, allocation); }
+    void Buffer::Unmap() {
+        if (!GetMappedData()) {
+            vmaUnmapMemory(allocator, allocation);
+        }
+    }
+
+    std::byte *Buffer::GetMappedData() const { return static_cast<std::byte *>(allocationInfo.pMappedData); }
 
     void Buffer::Flush(const VkDeviceSize offset, const VkDeviceSize size) {
-        CHECK_RESULT_VK(vmaFlushAllocation(allocator, allocation, offset, size));
+        if (!IsHostCoherent()) {
+            CHECK_RESULT_VK(vmaFlushAllocation(allocator, allocation, offset, size));
+        }
     }
 
+    void Buffer::Invalidate(const VkDeviceSize offset, const VkDeviceSize size) {
+        if (!IsHostCoherent()) {
+            CHECK_RESULT_VK(vmaInvalidateAllocation(allocator, allocation, offset, size));
+        }
+    }
+
+    bool Buffer::IsHostVisible() const { return memoryPropertyFlags & VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT; }
+
+    bool Buffer::IsHostCoherent() const { return memoryPropertyFlags & VK_MEMORY_PROPERTY_HOST_COHERENT_BIT; }
+
     void Buffer::CmdBarrier(VkCommandBuffer commandBuffer, VkPipelineStageFlags2 srcStageMask,
                             VkAccessFlags2 srcAccessMask, VkPipelineStageFlags2 dstStageMask,
-                            VkAccessFlags2 dstAccessMask, VkDeviceSize offset, VkDeviceSize size) {
+                            VkAccessFlags2 dstAccessMask, VkDeviceSize offset, VkDeviceSize size,
+                            uint32_t srcQueueFamilyIndex, uint32_t dstQueueFamilyIndex) {
         VkBufferMemoryBarrier2 buffer_memory_barrier{
                 .sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER_2,
                 .srcStageMask = srcStageMask,
                 .srcAccessMask = srcAccessMask,
                 .dstStageMask = dstStageMask,
                 .dstAccessMask = dstAccessMask,
-                .srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED, // TODO: Support Queue Family Transfer
-                .dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+                .srcQueueFamilyIndex = srcQueueFamilyIndex,
+                .dstQueueFamilyIndex = dstQueueFamilyIndex,
                 .buffer = buffer,
                 .offset = offset,
                 .size = size};
@@ -67,12 +96,17 @@ namespace Vkxel::VkUtil {
         Buffer buffer = {.device = _device,
                          .allocator = _allocator,
                          .createInfo = _create_info,
-                         .allocationCreateInfo = _allocation_info};
+                         .allocationCreateInfo = _allocation_info,
+                         .category = _category};
 
         if (_create_buffer_view) {
             buffer.viewCreateInfo = _view_create_info;
         }
 
+        if (_persistent_mapped) {
+            buffer.allocationCreateInfo.flags |= VMA_ALLOCATION_CREATE_MAPPED_BIT;
+        }
+
         return buffer;
     }
 
@@ -151,6 +185,16 @@ namespace Vkxel::VkUtil {
         return *this;
     }
 
+    BufferBuilder &BufferBuilder::SetPersistentMapped(bool persistentMapped) {
+        _persistent_mapped = persistentMapped;
+        return *this;
+    }
+
+    BufferBuilder &BufferBuilder::SetCategory(const MemoryCategory category) {
+        _category = category;
+        return *this;
+    }
+
     BufferBuilder &BufferBuilder::SetViewFormat(VkFormat format) {
         _view_create_info.format = format;
         return *this;
@@ -5,11 +5,14 @@
 #ifndef VKXEL_BUFFER_H
 #define VKXEL_BUFFER_H
 
+#include <cstddef>
 #include <utility>
 
 #include "vk_mem_alloc.h"
 #include "vulkan/vulkan.h"
 
+#include "memory.h"
+
 namespace Vkxel::VkUtil {
     struct Buffer {
         VkDevice device = nullptr;
@@ -21,17 +24,27 @@ namespace Vkxel::VkUtil {
         VmaAllocationInfo allocationInfo = {};
         VkBufferView bufferView = nullptr;
         VkBufferViewCreateInfo viewCreateInfo = {};
+        VkMemoryPropertyFlags memoryPropertyFlags = 0;
+        MemoryCategory category = MemoryCategory::Uncategorized;
 
         void Create();
         void Destroy();
 
+        // Persistently mapped buffers return the cached pointer and Unmap does nothing
         std::byte *Map();
         void Unmap();
+        // Null unless created with BufferBuilder::SetPersistentMapped and placed in host visible memory
+        std::byte *GetMappedData() const;
+        // No-op on host coherent memory, VMA aligns the range to nonCoherentAtomSize otherwise
         void Flush(VkDeviceSize offset = 0, VkDeviceSize size = VK_WHOLE_SIZE);
+        void Invalidate(VkDeviceSize offset = 0, VkDeviceSize size = VK_WHOLE_SIZE);
+        bool IsHostVisible() const;
+        bool IsHostCoherent() const;
 
         void CmdBarrier(VkCommandBuffer commandBuffer, VkPipelineStageFlags2 srcStageMask, VkAccessFlags2 srcAccessMask,
                         VkPipelineStageFlags2 dstStageMask, VkAccessFlags2 dstAccessMask, VkDeviceSize offset = 0,
-                        VkDeviceSize size = VK_WHOLE_SIZE);
+                        VkDeviceSize size = VK_WHOLE_SIZE, uint32_t srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+                        uint32_t dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED);
     };
 
     class BufferBuilder {
@@ -42,7 +55,7 @@ namespace Vkxel::VkUtil {
         explicit BufferBuilder(const Buffer &oldBuffer) :
             _device(oldBuffer.device), _allocator(oldBuffer.allocator), _create_info(oldBuffer.createInfo),
             _view_create_info(oldBuffer.viewCreateInfo), _allocation_info(oldBuffer.allocationCreateInfo),
-            _create_buffer_view(oldBuffer.bufferView != nullptr) {}
+            _create_buffer_view(oldBuffer.bufferView != nullptr), _category(oldBuffer.category) {}
 
         Buffer Build() const;
 
@@ -63,6 +76,10 @@ namespace Vkxel::VkUtil {
         BufferBuilder &SetPool(VmaPool pool);
         BufferBuilder &SetPUserData(void *pUserData);
         BufferBuilder &SetPriority(float priority);
+        // Map for the whole lifetime of the buffer, kept regardless of later SetAllocationFlags calls
+        BufferBuilder &SetPersistentMapped(bool persistentMapped = true);
+        // Reported by MemoryStatistics and as the VMA allocation name
+        BufferBuilder &SetCategory(MemoryCategory category);
 
         BufferBuilder &SetViewFormat(VkFormat format);
         BufferBuilder &SetViewOffset(VkDeviceSize offset);
@@ -72,6 +89,8 @@ namespace Vkxel::VkUtil {
         VkDevice _device = nullptr;
         VmaAllocator _allocator = nullptr;
         bool _create_buffer_view = false;
+        bool _persistent_mapped = false;
+        MemoryCategory _category = MemoryCategory::Uncategorized;
 
         VkBufferCreateInfo _create_info{.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO,
                                         .pNext = nullptr,
@@ -2,6 +2,8 @@
 // Created by jiayi on 2/7/2025.
 //
 
+#include <limits>
+
 #include "vulkan/vulkan.h"
 
 #include "command.h"
@@ -9,48 +11,158 @@
 
 namespace Vkxel::VkUtil {
 
-    VkCommandBuffer ImmediateCommand::Begin() {
-        CHECK(!_is_recording);
-        _is_recording = true;
-
-        VkCommandBufferAllocateInfo command_buffer_allocate_info{.sType =
-                                                                         VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO,
-                                                                 .commandPool = _command_pool,
-                                                                 .level = VK_COMMAND_BUFFER_LEVEL_PRIMARY,
-                                                                 .commandBufferCount = 1};
-
-        CHECK_RESULT_VK(vkAllocateCommandBuffers(_device, &command_buffer_allocate_info, &_command_buffer));
+    void ImmediateTicket::Wait() const {
+        if (pool) {
+            pool->Wait(value);
+        }
+    }
 
+    bool ImmediateTicket::IsComplete() const { return !pool || pool->IsComplete(value); }
+
+    VkCommandBuffer ImmediateCommandPool::Begin() {
+        if (!_timeline_semaphore) {
+            VkSemaphoreTypeCreateInfo semaphore_type_create_info{.sType = VK_STRUCTURE_TYPE_SEMAPHORE_TYPE_CREATE_INFO,
+                                                                 .semaphoreType = VK_SEMAPHORE_TYPE_TIMELINE,
+                                                                 .initialValue = 0};
+            VkSemaphoreCreateInfo semaphore_create_info{.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO,
+                                                        .pNext = &semaphore_type_create_info};
+            CHECK_RESULT_VK(vkCreateSemaphore(_device, &semaphore_create_info, nullptr, &_timeline_semaphore));
+        }
+
+        Recycle();
+
+        VkCommandBuffer command_buffer = nullptr;
+        if (_free_command_buffer.empty()) {
+            VkCommandBufferAllocateInfo command_buffer_allocate_info{
+                    .sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO,
+                    .commandPool = _command_pool,
+                    .level = VK_COMMAND_BUFFER_LEVEL_PRIMARY,
+                    .commandBufferCount = 1};
+            CHECK_RESULT_VK(vkAllocateCommandBuffers(_device, &command_buffer_allocate_info, &command_buffer));
+        } else {
+            command_buffer = _free_command_buffer.back();
+            _free_command_buffer.pop_back();
+        }
+
+        // Begin implicitly resets the recycled command buffer
         VkCommandBufferBeginInfo command_buffer_begin_info{.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO,
                                                            .flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT};
-
-        CHECK_RESULT_VK(vkBeginCommandBuffer(_command_buffer, &command_buffer_begin_info));
-        return _command_buffer;
+        CHECK_RESULT_VK(vkBeginCommandBuffer(command_buffer, &command_buffer_begin_info));
+        return command_buffer;
     }
 
-    void ImmediateCommand::End() {
-        CHECK(_is_recording);
-        _is_recording = false;
+    ImmediateTicket ImmediateCommandPool::Submit(const VkCommandBuffer commandBuffer,
+                                                 const std::vector<VkSemaphoreSubmitInfo> &waitSemaphore) {
+        CHECK_RESULT_VK(vkEndCommandBuffer(commandBuffer));
 
-        CHECK_RESULT_VK(vkEndCommandBuffer(_command_buffer));
-
-        VkFenceCreateInfo fence_create_info{
-                .sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO,
-        };
-        CHECK_RESULT_VK(vkCreateFence(_device, &fence_create_info, nullptr, &_fence));
+        const uint64_t timeline_value = ++_timeline_value;
 
         VkCommandBufferSubmitInfo command_buffer_submit_info{.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_SUBMIT_INFO,
-                                                             .commandBuffer = _command_buffer};
-
+                                                             .commandBuffer = commandBuffer};
+        VkSemaphoreSubmitInfo signal_semaphore_info{.sType = VK_STRUCTURE_TYPE_SEMAPHORE_SUBMIT_INFO,
+                                                    .semaphore = _timeline_semaphore,
+                                                    .value = timeline_value,
+                                                    .stageMask = VK_PIPELINE_STAGE_2_ALL_COMMANDS_BIT};
         VkSubmitInfo2 submit_info{.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO_2,
+                                  .waitSemaphoreInfoCount = static_cast<uint32_t>(waitSemaphore.size()),
+                                  .pWaitSemaphoreInfos = waitSemaphore.data(),
                                   .commandBufferInfoCount = 1,
-                                  .pCommandBufferInfos = &command_buffer_submit_info};
-        vkQueueSubmit2(_queue, 1, &submit_info, _fence);
+                                  .pCommandBufferInfos = &command_buffer_submit_info,
+                                  .signalSemaphoreInfoCount = 1,
+                                  .pSignalSemaphoreInfos = &signal_semaphore_info};
+        CHECK_RESULT_VK(vkQueueSubmit2(_queue, 1, &submit_info, nullptr));
+
+        _in_flight_command.push_back({.commandBuffer = commandBuffer, .timelineValue = timeline_value});
+        return {.pool = this, .value = timeline_value};
+    }
+
+    void ImmediateCommandPool::Wait(const uint64_t value) const {
+        if (value == 0 || !_timeline_semaphore) {
+            return;
+        }
+
+        VkSemaphoreWaitInfo semaphore_wait_info{.sType = VK_STRUCTURE_TYPE_SEMAPHORE_WAIT_INFO,
+                                                .semaphoreCount = 1,
+                                                .pSemaphores = &_timeline_semaphore,
+                                                .pValues = &value};
+        CHECK_RESULT_VK(vkWaitSemaphores(_device, &semaphore_wait_info, std::numeric_limits<uint64_t>::max()));
+    }
+
+    void ImmediateCommandPool::WaitIdle() const { Wait(_timeline_value); }
+
+    bool ImmediateCommandPool::IsComplete(const uint64_t value) const { return GetCompletedValue() >= value; }
+
+    VkSemaphore ImmediateCommandPool::GetTimelineSemaphore() const { return _timeline_semaphore; }
 
-        CHECK_RESULT_VK(vkWaitForFences(_device, 1, &_fence, VK_TRUE, std::numeric_limits<uint64_t>::max()));
-        vkDestroyFence(_device, _fence, nullptr);
+    void ImmediateCommandPool::Destroy() {
+        if (!_timeline_semaphore) {
+            return;
+        }
+
+        WaitIdle();
+        Recycle();
+        if (!_free_command_buffer.empty()) {
+            vkFreeCommandBuffers(_device, _command_pool, static_cast<uint32_t>(_free_command_buffer.size()),
+                                 _free_command_buffer.data());
+        }
+        _free_command_buffer = {};
+
+        vkDestroySemaphore(_device, _timeline_semaphore, nullptr);
+        _timeline_semaphore = nullptr;
+        _timeline_value = 0;
+    }
+
+    uint64_t ImmediateCommandPool::GetCompletedValue() const {
+        if (!_timeline_semaphore) {
+            return 0;
+        }
+
+        uint64_t completed_value = 0;
+        CHECK_RESULT_VK(vkGetSemaphoreCounterValue(_device, _timeline_semaphore, &completed_value));
+        return completed_value;
+    }
+
+    void ImmediateCommandPool::Recycle() {
+        if (_in_flight_command.empty()) {
+            return;
+        }
+
+        const uint64_t completed_value = GetCompletedValue();
+        std::erase_if(_in_flight_command, [&](const InFlightCommand &command) {
+            if (command.timelineValue > completed_value) {
+                return false;
+            }
+            _free_command_buffer.push_back(command.commandBuffer);
+            return true;
+        });
+    }
+
+    VkCommandBuffer ImmediateCommand::Begin() {
+        CHECK(!_is_recording);
+        _is_recording = true;
+
+        _command_buffer = _command_pool.Begin();
+        return _command_buffer;
+    }
+
+    void ImmediateCommand::AddWaitSemaphore(const VkSemaphore semaphore, const uint64_t value,
+                                            const VkPipelineStageFlags2 stageMask) {
+        _wait_semaphore.push_back({.sType = VK_STRUCTURE_TYPE_SEMAPHORE_SUBMIT_INFO,
+                                   .semaphore = semaphore,
+                                   .value = value,
+                                   .stageMask = stageMask});
+    }
+
+    void ImmediateCommand::End() { Submit().Wait(); }
+
+    ImmediateTicket ImmediateCommand::Submit() {
+        CHECK(_is_recording);
+        _is_recording = false;
 
-        vkFreeCommandBuffers(_device, _command_pool, 1, &_command_buffer);
+        const ImmediateTicket ticket = _command_pool.Submit(_command_buffer, _wait_semaphore);
+        _wait_semaphore.clear();
+        _command_buffer = nullptr;
+        return ticket;
     }
 
     void ImmediateCommand::Run(const std::function<void(VkCommandBuffer)> &command) {
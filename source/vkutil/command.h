@@ -5,29 +5,86 @@
 #ifndef VKXEL_COMMAND_H
 #define VKXEL_COMMAND_H
 
+#include <cstdint>
 #include <functional>
+#include <vector>
 
 #include "vulkan/vulkan.h"
 
 namespace Vkxel::VkUtil {
 
-    class ImmediateCommand {
+    class ImmediateCommandPool;
+
+    // Timeline value of one immediate submission
+    struct ImmediateTicket {
+        const ImmediateCommandPool *pool = nullptr;
+        uint64_t value = 0;
+
+        void Wait() const;
+        bool IsComplete() const;
+    };
+
+    // Recycled command buffers for one queue, every submission signals the next value of a single timeline
+    // semaphore instead of a fence, command buffers return to the free list once their value is reached
+    class ImmediateCommandPool {
     public:
-        ImmediateCommand(const VkDevice device, const VkQueue queue, const VkCommandPool commandPool) :
+        ImmediateCommandPool(const VkDevice device, const VkQueue queue, const VkCommandPool commandPool) :
             _device(device), _queue(queue), _command_pool(commandPool) {}
 
+        // Command buffer in recording state, the pool must allow resetting individual command buffers
         VkCommandBuffer Begin();
-        void End();
+        // End and submit without waiting on host
+        ImmediateTicket Submit(VkCommandBuffer commandBuffer,
+                               const std::vector<VkSemaphoreSubmitInfo> &waitSemaphore = {});
 
-        void Run(const std::function<void(VkCommandBuffer)> &command);
+        void Wait(uint64_t value) const;
+        // Wait for every submission so far
+        void WaitIdle() const;
+        bool IsComplete(uint64_t value) const;
+
+        // Created on first Begin
+        VkSemaphore GetTimelineSemaphore() const;
+
+        void Destroy();
 
     private:
+        struct InFlightCommand {
+            VkCommandBuffer commandBuffer;
+            uint64_t timelineValue;
+        };
+
+        uint64_t GetCompletedValue() const;
+        void Recycle();
+
         VkDevice _device = nullptr;
         VkQueue _queue = nullptr;
         VkCommandPool _command_pool = nullptr;
 
+        VkSemaphore _timeline_semaphore = nullptr;
+        uint64_t _timeline_value = 0;
+        std::vector<VkCommandBuffer> _free_command_buffer = {};
+        std::vector<InFlightCommand> _in_flight_command = {};
+    };
+
+    class ImmediateCommand {
+    public:
+        explicit ImmediateCommand(ImmediateCommandPool &commandPool) : _command_pool(commandPool) {}
+
+        VkCommandBuffer Begin();
+        // Semaphore the submission waits for, binary semaphores ignore value
+        void AddWaitSemaphore(VkSemaphore semaphore, uint64_t value, VkPipelineStageFlags2 stageMask);
+        // Submit and wait on host
+        void End();
+        // Submit without waiting, several tickets of the same pool only need the last one waited
+        ImmediateTicket Submit();
+
+        void Run(const std::function<void(VkCommandBuffer)> &command);
+
+    private:
+        ImmediateCommandPool &_command_pool;
+
         VkCommandBuffer _command_buffer = nullptr;
-        VkFence _fence = nullptr;
+        std::vector<VkSemaphoreSubmitInfo> _wait_semaphore;
 
         bool _is_recording = false;
     };
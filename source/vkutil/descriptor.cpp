@@ -2,11 +2,20 @@
 // Created by jiayi on 2/7/2025.
 //
 
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
 #include "descriptor.h"
 #include "util/check.h"
 
 namespace Vkxel::VkUtil {
     void DescriptorSet::Create() {
+        if (allocator) {
+            set = allocator->Allocate(layout, pool);
+            return;
+        }
+
         VkDescriptorSetAllocateInfo descriptor_set_allocate_info{.sType =
                                                                          VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO,
                                                                  .descriptorPool = pool,
@@ -16,7 +25,114 @@ namespace Vkxel::VkUtil {
         CHECK_RESULT_VK(vkAllocateDescriptorSets(device, &descriptor_set_allocate_info, &set));
     }
 
-    void DescriptorSet::Destroy() { CHECK_RESULT_VK(vkFreeDescriptorSets(device, pool, 1, &set)); }
+    void DescriptorSet::Destroy() {
+        if (allocator) {
+            allocator->Free(pool, set);
+        } else {
+            CHECK_RESULT_VK(vkFreeDescriptorSets(device, pool, 1, &set));
+        }
+        set = nullptr;
+    }
+
+    VkDescriptorSet DescriptorAllocator::Allocate(const VkDescriptorSetLayout layout, VkDescriptorPool &pool) {
+        Flush();
+
+        VkDescriptorSetAllocateInfo descriptor_set_allocate_info{.sType =
+                                                                         VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO,
+                                                                 .descriptorSetCount = 1,
+                                                                 .pSetLayouts = &layout};
+
+        // Exhausted pools are retired until one fits
+        while (true) {
+            const bool new_pool = _ready_pool.empty();
+            pool = GetPool();
+            descriptor_set_allocate_info.descriptorPool = pool;
+
+            VkDescriptorSet set = nullptr;
+            const VkResult result = vkAllocateDescriptorSets(_device, &descriptor_set_allocate_info, &set);
+            if (result != VK_ERROR_OUT_OF_POOL_MEMORY && result != VK_ERROR_FRAGMENTED_POOL) {
+                CHECK_RESULT_VK(result);
+                return set;
+            }
+            CHECK(!new_pool, "Descriptor Set Layout Exceeds Pool Size Ratio");
+
+            _full_pool.push_back(pool);
+            _ready_pool.pop_back();
+        }
+    }
+
+    void DescriptorAllocator::Free(const VkDescriptorPool pool, const VkDescriptorSet set) {
+        if (set && (_flags & VK_DESCRIPTOR_POOL_CREATE_FREE_DESCRIPTOR_SET_BIT)) {
+            _pending_free[pool].push_back(set);
+        }
+    }
+
+    void DescriptorAllocator::Flush() {
+        if (_pending_free.empty()) {
+            return;
+        }
+
+        for (auto &[pool, sets]: _pending_free) {
+            CHECK_RESULT_VK(vkFreeDescriptorSets(_device, pool, static_cast<uint32_t>(sets.size()), sets.data()));
+
+            // A pool with freed sets may fit new ones again, it is tried before the current pool
+            if (const auto full = std::ranges::find(_full_pool, pool); full != _full_pool.end()) {
+                _full_pool.erase(full);
+                _ready_pool.push_back(pool);
+            }
+        }
+        _pending_free.clear();
+    }
+
+    void DescriptorAllocator::Reset() {
+        _pending_free.clear();
+        _ready_pool.insert(_ready_pool.end(), _full_pool.begin(), _full_pool.end());
+        _full_pool.clear();
+        for (const VkDescriptorPool pool: _ready_pool) {
+            CHECK_RESULT_VK(vkResetDescriptorPool(_device, pool, 0));
+        }
+    }
+
+    void DescriptorAllocator::Destroy() {
+        _pending_free.clear();
+        for (const VkDescriptorPool pool: _ready_pool) {
+            vkDestroyDescriptorPool(_device, pool, nullptr);
+        }
+        for (const VkDescriptorPool pool: _full_pool) {
+            vkDestroyDescriptorPool(_device, pool, nullptr);
+        }
+        _ready_pool.clear();
+        _full_pool.clear();
+    }
+
+    VkDescriptorPool DescriptorAllocator::GetPool() {
+        if (_ready_pool.empty()) {
+            // Each chained pool is half again as large as the previous one
+            _ready_pool.push_back(CreatePool(_sets_per_pool));
+            _sets_per_pool = std::min(_sets_per_pool + _sets_per_pool / 2, MaxSetsPerPool);
+        }
+        return _ready_pool.back();
+    }
+
+    VkDescriptorPool DescriptorAllocator::CreatePool(const uint32_t setCount) const {
+        std::vector<VkDescriptorPoolSize> pool_size;
+        pool_size.reserve(_pool_size_ratio.size());
+        for (const auto &[type, ratio]: _pool_size_ratio) {
+            pool_size.push_back({.type = type,
+                                 .descriptorCount = std::max(1u, static_cast<uint32_t>(std::ceil(ratio * setCount)))});
+        }
+
+        VkDescriptorPoolCreateInfo descriptor_pool_create_info{.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO,
+                                                               .flags = _flags,
+                                                               .maxSets = setCount,
+                                                               .poolSizeCount =
+                                                                       static_cast<uint32_t>(pool_size.size()),
+                                                               .pPoolSizes = pool_size.data()};
+
+        VkDescriptorPool pool = nullptr;
+        CHECK_RESULT_VK(vkCreateDescriptorPool(_device, &descriptor_pool_create_info, nullptr, &pool));
+        return pool;
+    }
 
 
 } // namespace Vkxel::VkUtil
@@ -5,33 +5,92 @@
 #ifndef VKXEL_DESCRIPTOR_H
 #define VKXEL_DESCRIPTOR_H
 
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
 #include "vulkan/vulkan.h"
 
 namespace Vkxel::VkUtil {
 
+    class DescriptorAllocator;
+
     struct DescriptorSet {
         VkDevice device = nullptr;
         VkDescriptorSet set = nullptr;
         VkDescriptorSetLayout layout = nullptr;
         VkDescriptorPool pool = nullptr;
+        // Allocated from one of its pools when set, pool is then the pool the set came from
+        DescriptorAllocator *allocator = nullptr;
 
         void Create();
         void Destroy();
     };
 
+    // Chain of descriptor pools growing on exhaustion, individual sets are only freed when the allocator was created
+    // with VK_DESCRIPTOR_POOL_CREATE_FREE_DESCRIPTOR_SET_BIT, otherwise they are all released together by Reset
+    class DescriptorAllocator {
+    public:
+        // Descriptors of a type per set in a pool
+        struct PoolSizeRatio {
+            VkDescriptorType type;
+            float ratio;
+        };
+
+        static constexpr uint32_t MaxSetsPerPool = 4096;
+
+        DescriptorAllocator(const VkDevice device, const uint32_t setsPerPool,
+                            const std::vector<PoolSizeRatio> &poolSizeRatio,
+                            const VkDescriptorPoolCreateFlags flags = 0) :
+            _device(device), _sets_per_pool(setsPerPool), _pool_size_ratio(poolSizeRatio), _flags(flags) {}
+
+        // Allocate from the current pool, a new larger pool is chained when it is out of sets or descriptors
+        VkDescriptorSet Allocate(VkDescriptorSetLayout layout, VkDescriptorPool &pool);
+        // Queue the set, queued sets are returned with one vkFreeDescriptorSets per pool on the next Allocate or
+        // Flush, without the free bit the set stays allocated until Reset
+        void Free(VkDescriptorPool pool, VkDescriptorSet set);
+        void Flush();
+        // Release every set at once, pools are kept for reuse
+        void Reset();
+        void Destroy();
+
+    private:
+        VkDescriptorPool GetPool();
+        VkDescriptorPool CreatePool(uint32_t setCount) const;
+
+        VkDevice _device = nullptr;
+        uint32_t _sets_per_pool = 0;
+        std::vector<PoolSizeRatio> _pool_size_ratio = {};
+        VkDescriptorPoolCreateFlags _flags = 0;
+
+        // Pools that may still have space, the last one is allocated from
+        std::vector<VkDescriptorPool> _ready_pool = {};
+        std::vector<VkDescriptorPool> _full_pool = {};
+        std::unordered_map<VkDescriptorPool, std::vector<VkDescriptorSet>> _pending_free = {};
+    };
+
     class DescriptorSetBuilder {
     public:
         DescriptorSetBuilder(VkDevice device, VkDescriptorPool descriptorPool,
                              VkDescriptorSetLayout descriptorSetLayout) :
             _device(device), _descriptor_pool(descriptorPool), _descriptor_set_layout(descriptorSetLayout) {}
 
+        DescriptorSetBuilder(VkDevice device, DescriptorAllocator &descriptorAllocator,
+                             VkDescriptorSetLayout descriptorSetLayout) :
+            _device(device), _descriptor_allocator(&descriptorAllocator), _descriptor_set_layout(descriptorSetLayout) {}
+
         DescriptorSet Build() {
-            return {.device = _device, .set = nullptr, .layout = _descriptor_set_layout, .pool = _descriptor_pool};
+            return {.device = _device,
+                    .set = nullptr,
+                    .layout = _descriptor_set_layout,
+                    .pool = _descriptor_pool,
+                    .allocator = _descriptor_allocator};
         }
 
     private:
         VkDevice _device = nullptr;
         VkDescriptorPool _descriptor_pool = nullptr;
+        DescriptorAllocator *_descriptor_allocator = nullptr;
         VkDescriptorSetLayout _descriptor_set_layout = nullptr;
     };
 
@@ -6,6 +6,7 @@
 #include "vulkan/vulkan.h"
 
 #include "image.h"
+#include "memory.h"
 #include "util/check.h"
 
 namespace Vkxel::VkUtil {
@@ -13,6 +14,8 @@ namespace Vkxel::VkUtil {
     void Image::Create() {
         CHECK_RESULT_VK(
                 vmaCreateImage(allocator, &createInfo, &allocationCreateInfo, &image, &allocation, &allocationInfo));
+        vmaSetAllocationName(allocator, allocation, GetMemoryCategoryName(category).data());
+        MemoryStatistics::Track(category, allocationInfo.size);
 
         if (viewCreateInfo.sType == VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO) {
             viewCreateInfo.image = image;
@@ -25,6 +28,9 @@ namespace Vkxel::VkUtil {
         if (imageView) {
             vkDestroyImageView(device, imageView, nullptr);
         }
+        if (allocation) {
+            MemoryStatistics::Untrack(category, allocationInfo.size);
+        }
         vmaDestroyImage(allocator, image, allocation);
     }
 
@@ -73,7 +79,8 @@ namespace Vkxel::VkUtil {
         Image image = {.device = _device,
                        .allocator = _allocator,
                        .createInfo = _create_info,
-                       .allocationCreateInfo = _allocation_info};
+                       .allocationCreateInfo = _allocation_info,
+                       .category = _category};
 
         if (_create_image_view) {
             image.viewCreateInfo = _view_create_info;
@@ -200,6 +207,11 @@ namespace Vkxel::VkUtil {
         return *this;
     }
 
+    ImageBuilder &ImageBuilder::SetCategory(const MemoryCategory category) {
+        _category = category;
+        return *this;
+    }
+
     ImageBuilder &ImageBuilder::SetViewFlags(VkImageViewCreateFlags flags) {
         _view_create_info.flags = flags;
         return *this;
@@ -10,6 +10,8 @@
 #include "vk_mem_alloc.h"
 #include "vulkan/vulkan.h"
 
+#include "memory.h"
+
 namespace Vkxel::VkUtil {
     struct Image {
         VkDevice device = nullptr;
@@ -21,6 +23,7 @@ namespace Vkxel::VkUtil {
         VmaAllocationInfo allocationInfo = {};
         VkImageView imageView = nullptr;
         VkImageViewCreateInfo viewCreateInfo = {};
+        MemoryCategory category = MemoryCategory::Uncategorized;
 
         void Create();
         void Destroy();
@@ -42,7 +45,7 @@ namespace Vkxel::VkUtil {
         explicit ImageBuilder(const Image &oldImage) :
             _device(oldImage.device), _allocator(oldImage.allocator), _create_info(oldImage.createInfo),
             _view_create_info(oldImage.viewCreateInfo), _allocation_info(oldImage.allocationCreateInfo),
-            _create_image_view(oldImage.imageView != nullptr) {}
+            _create_image_view(oldImage.imageView != nullptr), _category(oldImage.category) {}
 
         Image Build() const;
 
@@ -71,6 +74,8 @@ namespace Vkxel::VkUtil {
         ImageBuilder &SetPool(VmaPool pool);
         ImageBuilder &SetPUserData(void *pUserData);
         ImageBuilder &SetPriority(float priority);
+        // Reported by MemoryStatistics and as the VMA allocation name
+        ImageBuilder &SetCategory(MemoryCategory category);
 
         ImageBuilder &SetViewFlags(VkImageViewCreateFlags flags);
         ImageBuilder &SetViewPNext(const void *pNext);
@@ -84,6 +89,7 @@ namespace Vkxel::VkUtil {
         VmaAllocator _allocator = nullptr;
 
         bool _create_image_view = false;
+        MemoryCategory _category = MemoryCategory::Uncategorized;
 
         VkImageCreateInfo _create_info{.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO,
                                        .pNext = nullptr,
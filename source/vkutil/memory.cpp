@@ -0,0 +1,147 @@
+//
+// Created by jiayi on 10/19/2026.
+//
+
+#include <algorithm>
+#include <iterator>
+#include <map>
+#include <mutex>
+#include <ranges>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include "rfl/Generic.hpp"
+#include "rfl/json.hpp"
+#include "vk_mem_alloc.h"
+#include "vulkan/vulkan.h"
+
+#include "memory.h"
+
+namespace Vkxel::VkUtil {
+
+    namespace {
+        struct HeapStatistics {
+            VkDeviceSize usage;
+            VkDeviceSize budget;
+            VkDeviceSize allocationBytes;
+            VkDeviceSize blockBytes;
+            uint32_t allocationCount;
+        };
+
+        struct MemoryReport {
+            std::map<std::string, MemoryStatistics::CategoryStatistics> categories;
+            std::vector<HeapStatistics> heaps;
+            // Detailed statistics built by VMA, parsed so they are embedded as JSON rather than a string
+            rfl::Generic vma;
+        };
+    } // namespace
+
+    std::string_view GetMemoryCategoryName(const MemoryCategory category) {
+        switch (category) {
+            case MemoryCategory::Uncategorized:
+                return "Uncategorized";
+            case MemoryCategory::Mesh:
+                return "Mesh";
+            case MemoryCategory::ComputeScratch:
+                return "ComputeScratch";
+            case MemoryCategory::Staging:
+                return "Staging";
+            case MemoryCategory::FrameTarget:
+                return "FrameTarget";
+            default:
+                return "Unknown";
+        }
+    }
+
+    void MemoryStatistics::Track(const MemoryCategory category, const VkDeviceSize size) {
+        _bytes[static_cast<size_t>(category)] += size;
+        ++_count[static_cast<size_t>(category)];
+    }
+
+    void MemoryStatistics::Untrack(const MemoryCategory category, const VkDeviceSize size) {
+        _bytes[static_cast<size_t>(category)] -= size;
+        --_count[static_cast<size_t>(category)];
+    }
+
+    MemoryStatistics::CategoryStatistics MemoryStatistics::Get(const MemoryCategory category) {
+        return {.bytes = _bytes[static_cast<size_t>(category)], .count = _count[static_cast<size_t>(category)]};
+    }
+
+    std::vector<VmaBudget> MemoryStatistics::GetHeapBudgets(const VmaAllocator allocator) {
+        const VkPhysicalDeviceMemoryProperties *memory_properties = nullptr;
+        vmaGetMemoryProperties(allocator, &memory_properties);
+
+        std::vector<VmaBudget> budget(memory_properties->memoryHeapCount);
+        vmaGetHeapBudgets(allocator, budget.data());
+        return budget;
+    }
+
+    std::string MemoryStatistics::ToJson(const VmaAllocator allocator) {
+        MemoryReport report;
+        for (size_t index = 0; index < CategoryCount; ++index) {
+            const auto category = static_cast<MemoryCategory>(index);
+            report.categories.emplace(GetMemoryCategoryName(category), Get(category));
+        }
+
+        for (const VmaBudget &budget: GetHeapBudgets(allocator)) {
+            report.heaps.push_back({.usage = budget.usage,
+                                    .budget = budget.budget,
+                                    .allocationBytes = budget.statistics.allocationBytes,
+                                    .blockBytes = budget.statistics.blockBytes,
+                                    .allocationCount = budget.statistics.allocationCount});
+        }
+
+        char *vma_statistics = nullptr;
+        vmaBuildStatsString(allocator, &vma_statistics, VK_TRUE);
+        report.vma = rfl::json::read<rfl::Generic>(vma_statistics).value();
+        vmaFreeStatsString(allocator, vma_statistics);
+
+        return rfl::json::write(report, rfl::json::pretty);
+    }
+
+    uint64_t MemoryStatistics::AddBudgetCallback(const BudgetCallback &callback) {
+        std::lock_guard lock(_callback_mutex);
+        const uint64_t handle = _next_callback_handle++;
+        _budget_callback.emplace(handle, callback);
+        return handle;
+    }
+
+    void MemoryStatistics::RemoveBudgetCallback(const uint64_t handle) {
+        std::lock_guard lock(_callback_mutex);
+        _budget_callback.erase(handle);
+    }
+
+    void MemoryStatistics::CheckBudget(const VmaAllocator allocator) {
+        const std::vector<VmaBudget> budget = GetHeapBudgets(allocator);
+
+        // Callbacks run outside the lock so they may add or remove callbacks themselves
+        std::vector<std::pair<uint32_t, float>> pressure;
+        std::vector<BudgetCallback> callback;
+        {
+            std::lock_guard lock(_callback_mutex);
+            _heap_under_pressure.resize(budget.size(), false);
+            for (uint32_t heap = 0; heap < budget.size(); ++heap) {
+                const float usage = budget[heap].budget > 0 ? static_cast<float>(budget[heap].usage) /
+                                                                      static_cast<float>(budget[heap].budget)
+                                                            : 0.0f;
+                const bool under_pressure = usage > PressureRatio;
+                if (under_pressure && !_heap_under_pressure[heap]) {
+                    pressure.emplace_back(heap, usage);
+                }
+                _heap_under_pressure[heap] = under_pressure;
+            }
+            if (!pressure.empty()) {
+                std::ranges::copy(_budget_callback | std::views::values, std::back_inserter(callback));
+            }
+        }
+
+        for (const auto &[heap, usage]: pressure) {
+            for (const auto &function: callback) {
+                function(heap, usage);
+            }
+        }
+    }
+
+} // namespace Vkxel::VkUtil
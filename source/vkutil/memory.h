@@ -0,0 +1,86 @@
+//
+// Created by jiayi on 10/19/2026.
+//
+
+#ifndef VKXEL_MEMORY_H
+#define VKXEL_MEMORY_H
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "vk_mem_alloc.h"
+#include "vulkan/vulkan.h"
+
+namespace Vkxel::VkUtil {
+
+    enum class MemoryCategory : uint32_t {
+        Uncategorized,
+        // Index, vertex, indirect and per object constant buffers
+        Mesh,
+        // Compute job buffers only touched by kernels or the host
+        ComputeScratch,
+        // Host visible copy sources and destinations
+        Staging,
+        // Per frame attachments and constant buffers
+        FrameTarget,
+        Count,
+    };
+
+    std::string_view GetMemoryCategoryName(MemoryCategory category);
+
+    // Live bytes and allocations of every category, updated by Buffer and Image Create and Destroy, and heap budgets
+    // reported by VMA
+    class MemoryStatistics {
+    public:
+        struct CategoryStatistics {
+            VkDeviceSize bytes = 0;
+            uint64_t count = 0;
+        };
+
+        // Heap index and usage divided by budget
+        using BudgetCallback = std::function<void(uint32_t, float)>;
+
+        MemoryStatistics() = delete;
+        ~MemoryStatistics() = delete;
+
+        // Heap usage above this fraction of its budget counts as pressure
+        static constexpr float PressureRatio = 0.9f;
+
+        static void Track(MemoryCategory category, VkDeviceSize size);
+        static void Untrack(MemoryCategory category, VkDeviceSize size);
+        static CategoryStatistics Get(MemoryCategory category);
+
+        static std::vector<VmaBudget> GetHeapBudgets(VmaAllocator allocator);
+        // Categories and heap budgets followed by the detailed VMA statistics
+        static std::string ToJson(VmaAllocator allocator);
+
+        // Callbacks run when a heap enters pressure, owners release what they can rebuild later,
+        // the returned handle removes the callback again
+        static uint64_t AddBudgetCallback(const BudgetCallback &callback);
+        static void RemoveBudgetCallback(uint64_t handle);
+        // Called once per frame
+        static void CheckBudget(VmaAllocator allocator);
+
+    private:
+        static constexpr size_t CategoryCount = static_cast<size_t>(MemoryCategory::Count);
+
+        inline static std::array<std::atomic<VkDeviceSize>, CategoryCount> _bytes = {};
+        inline static std::array<std::atomic<uint64_t>, CategoryCount> _count = {};
+
+        inline static std::mutex _callback_mutex;
+        inline static uint64_t _next_callback_handle = 1;
+        inline static std::map<uint64_t, BudgetCallback> _budget_callback = {};
+        // Heaps already reported, a heap is reported again after it leaves pressure
+        inline static std::vector<bool> _heap_under_pressure = {};
+    };
+
+} // namespace Vkxel::VkUtil
+
+#endif // VKXEL_MEMORY_H
@@ -3,17 +3,84 @@
 //
 
 #include <array>
+#include <span>
+#include <string_view>
+#include <vector>
 
 #include "engine/data_type.h"
+#include "engine/pipeline_cache.h"
 #include "engine/shader.h"
 #include "pipeline.h"
+#include "pipeline_registry.h"
 
 #include "util/application.h"
 #include "util/check.h"
+#include "util/hash.hpp"
 
 namespace Vkxel::VkUtil {
 
+    namespace {
+        VkShaderModule CreateShaderModule(const VkDevice device, const std::span<const uint8_t> shaderCode) {
+            VkShaderModuleCreateInfo shader_module_create_info{
+                    .sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO,
+                    .codeSize = shaderCode.size(),
+                    .pCode = reinterpret_cast<const uint32_t *>(shaderCode.data())};
+            VkShaderModule shader_module = nullptr;
+            CHECK_RESULT_VK(vkCreateShaderModule(device, &shader_module_create_info, nullptr, &shader_module));
+            return shader_module;
+        }
+
+        // Hash fields one by one, Vulkan structs may contain padding and pointers
+        class KeyBuilder {
+        public:
+            template<typename T>
+            KeyBuilder &Add(const T &value) {
+                _key = Hash::Value(value, _key);
+                return *this;
+            }
+
+            template<typename T>
+            KeyBuilder &AddSpan(std::span<const T> value) {
+                _key = Hash::Span(value, Hash::Value(value.size(), _key));
+                return *this;
+            }
+
+            KeyBuilder &AddString(const std::string_view value) {
+                _key = Hash::String(value, Hash::Value(value.size(), _key));
+                return *this;
+            }
+
+            KeyBuilder &AddSpecialization(const VkSpecializationInfo *specializationInfo) {
+                if (!specializationInfo) {
+                    return Add(0u);
+                }
+                for (const auto &entry: std::span(specializationInfo->pMapEntries, specializationInfo->mapEntryCount)) {
+                    Add(entry.constantID).Add(entry.offset).Add(entry.size);
+                }
+                return AddSpan(std::span(static_cast<const uint8_t *>(specializationInfo->pData),
+                                         specializationInfo->dataSize));
+            }
+
+            uint64_t Get() const { return _key; }
+
+        private:
+            uint64_t _key = Hash::Seed;
+        };
+    } // namespace
+
     void GraphicsPipeline::Destroy() {
+        if (registry) {
+            if (pipeline) {
+                registry->ReleasePipeline(pipeline);
+            }
+            if (layout) {
+                registry->ReleasePipelineLayout(layout);
+            }
+            pipeline = nullptr;
+            layout = nullptr;
+            return;
+        }
+
         if (pipeline) {
             vkDestroyPipeline(device, pipeline, nullptr);
             pipeline = nullptr;
@@ -25,6 +92,18 @@ namespace Vkxel::VkUtil {
     }
 
     void ComputePipeline::Destroy() {
+        if (registry) {
+            if (pipeline) {
+                registry->ReleasePipeline(pipeline);
+            }
+            if (layout) {
+                registry->ReleasePipelineLayout(layout);
+            }
+            pipeline = nullptr;
+            layout = nullptr;
+            return;
+        }
+
         if (pipeline) {
             vkDestroyPipeline(device, pipeline, nullptr);
             pipeline = nullptr;
@@ -43,27 +122,32 @@ namespace Vkxel::VkUtil {
                                                       .pushConstantRangeCount = 0,
                                                       .pPushConstantRanges = nullptr};
 
+        if (_pipeline_registry) {
+            CHECK(_shader_hash != 0, "Shared Pipelines Require A Shader Hash");
+            VkPipelineLayout pipeline_layout = _pipeline_registry->AcquirePipelineLayout(_descriptorSetLayouts, {});
+            VkGraphicsPipelineCreateInfo pipeline_create_info = GetCreateInfo(pipeline_layout);
+            VkPipeline pipeline = _pipeline_registry->AcquirePipeline(GetKey(pipeline_layout), [&]() {
+                VkPipeline created_pipeline = nullptr;
+                CHECK_RESULT_VK(vkCreateGraphicsPipelines(_device, _pipeline_cache, 1, &pipeline_create_info, nullptr,
+                                                          &created_pipeline));
+                return created_pipeline;
+            });
+
+            return {.device = _device,
+                    .pipeline = pipeline,
+                    .layout = pipeline_layout,
+                    .createInfo = pipeline_create_info,
+                    .layoutCreateInfo = layout_create_info,
+                    .registry = _pipeline_registry};
+        }
+
         VkPipelineLayout pipeline_layout = nullptr;
         CHECK_RESULT_VK(vkCreatePipelineLayout(_device, &layout_create_info, nullptr, &pipeline_layout));
 
-        VkGraphicsPipelineCreateInfo pipeline_create_info{.sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO,
-                                                          .pNext = &_pipelineRendering,
-                                                          .flags = 0,
-                                                          .stageCount = static_cast<uint32_t>(_shaderStages.size()),
-                                                          .pStages = _shaderStages.data(),
-                                                          .pVertexInputState = &_vertexInputInfo,
-                                                          .pInputAssemblyState = &_inputAssembly,
-                                                          .pViewportState = &_viewportState,
-                                                          .pRasterizationState = &_rasterizer,
-                                                          .pMultisampleState = &_multisampling,
-                                                          .pDepthStencilState = &_depthStencil,
-                                                          .pColorBlendState = &_colorBlending,
-                                                          .pDynamicState = &_dynamicState,
-                                                          .layout = pipeline_layout,
-                                                          .basePipelineHandle = VK_NULL_HANDLE,
-                                                          .basePipelineIndex = -1};
+        VkGraphicsPipelineCreateInfo pipeline_create_info = GetCreateInfo(pipeline_layout);
         VkPipeline pipeline = nullptr;
-        CHECK_RESULT_VK(vkCreateGraphicsPipelines(_device, nullptr, 1, &pipeline_create_info, nullptr, &pipeline));
+        CHECK_RESULT_VK(
+                vkCreateGraphicsPipelines(_device, _pipeline_cache, 1, &pipeline_create_info, nullptr, &pipeline));
 
         return {.device = _device,
                 .pipeline = pipeline,
@@ -72,6 +156,101 @@ namespace Vkxel::VkUtil {
                 .layoutCreateInfo = layout_create_info};
     }
 
+    uint64_t GraphicsPipelineBuilder::GetKey(const VkPipelineLayout layout) const {
+        KeyBuilder key;
+        key.Add(layout).Add(_shader_hash);
+
+        key.Add(_shaderStages.size());
+        for (const auto &stage: _shaderStages) {
+            key.Add(stage.flags).Add(stage.stage).AddString(stage.pName).AddSpecialization(stage.pSpecializationInfo);
+        }
+
+        key.Add(_vertexInputInfo.vertexBindingDescriptionCount);
+        for (const auto &binding: std::span(_vertexInputInfo.pVertexBindingDescriptions,
+                                            _vertexInputInfo.vertexBindingDescriptionCount)) {
+            key.Add(binding.binding).Add(binding.stride).Add(binding.inputRate);
+        }
+        key.Add(_vertexInputInfo.vertexAttributeDescriptionCount);
+        for (const auto &attribute: std::span(_vertexInputInfo.pVertexAttributeDescriptions,
+                                              _vertexInputInfo.vertexAttributeDescriptionCount)) {
+            key.Add(attribute.location).Add(attribute.binding).Add(attribute.format).Add(attribute.offset);
+        }
+
+        key.Add(_inputAssembly.topology).Add(_inputAssembly.primitiveRestartEnable);
+
+        key.Add(_viewportState.viewportCount).Add(_viewportState.scissorCount);
+        if (_viewportState.pViewports) {
+            key.AddSpan(std::span(_viewportState.pViewports, _viewportState.viewportCount));
+        }
+        if (_viewportState.pScissors) {
+            key.AddSpan(std::span(_viewportState.pScissors, _viewportState.scissorCount));
+        }
+
+        key.Add(_rasterizer.depthClampEnable)
+                .Add(_rasterizer.rasterizerDiscardEnable)
+                .Add(_rasterizer.polygonMode)
+                .Add(_rasterizer.cullMode)
+                .Add(_rasterizer.frontFace)
+                .Add(_rasterizer.depthBiasEnable)
+                .Add(_rasterizer.depthBiasConstantFactor)
+                .Add(_rasterizer.depthBiasClamp)
+                .Add(_rasterizer.depthBiasSlopeFactor)
+                .Add(_rasterizer.lineWidth);
+
+        key.Add(_multisampling.rasterizationSamples)
+                .Add(_multisampling.sampleShadingEnable)
+                .Add(_multisampling.minSampleShading)
+                .Add(_multisampling.alphaToCoverageEnable)
+                .Add(_multisampling.alphaToOneEnable);
+        if (_multisampling.pSampleMask) {
+            key.AddSpan(std::span(_multisampling.pSampleMask, (_multisampling.rasterizationSamples + 31) / 32));
+        }
+
+        key.Add(_depthStencil.depthTestEnable)
+                .Add(_depthStencil.depthWriteEnable)
+                .Add(_depthStencil.depthCompareOp)
+                .Add(_depthStencil.depthBoundsTestEnable)
+                .Add(_depthStencil.stencilTestEnable)
+                .Add(_depthStencil.front)
+                .Add(_depthStencil.back)
+                .Add(_depthStencil.minDepthBounds)
+                .Add(_depthStencil.maxDepthBounds);
+
+        key.Add(_colorBlending.logicOpEnable)
+                .Add(_colorBlending.logicOp)
+                .AddSpan(std::span(_colorBlending.pAttachments, _colorBlending.attachmentCount))
+                .Add(_colorBlending.blendConstants);
+
+        key.AddSpan(std::span(_dynamicState.pDynamicStates, _dynamicState.dynamicStateCount));
+
+        key.Add(_pipelineRendering.viewMask)
+                .AddSpan(std::span(_pipelineRendering.pColorAttachmentFormats,
+                                   _pipelineRendering.colorAttachmentCount))
+                .Add(_pipelineRendering.depthAttachmentFormat)
+                .Add(_pipelineRendering.stencilAttachmentFormat);
+
+        return key.Get();
+    }
+
+    VkGraphicsPipelineCreateInfo GraphicsPipelineBuilder::GetCreateInfo(const VkPipelineLayout layout) const {
+        return {.sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO,
+                .pNext = &_pipelineRendering,
+                .flags = 0,
+                .stageCount = static_cast<uint32_t>(_shaderStages.size()),
+                .pStages = _shaderStages.data(),
+                .pVertexInputState = &_vertexInputInfo,
+                .pInputAssemblyState = &_inputAssembly,
+                .pViewportState = &_viewportState,
+                .pRasterizationState = &_rasterizer,
+                .pMultisampleState = &_multisampling,
+                .pDepthStencilState = &_depthStencil,
+                .pColorBlendState = &_colorBlending,
+                .pDynamicState = &_dynamicState,
+                .layout = layout,
+                .basePipelineHandle = VK_NULL_HANDLE,
+                .basePipelineIndex = -1};
+    }
+
     GraphicsPipelineBuilder &
     GraphicsPipelineBuilder::SetShaderStages(const std::vector<VkPipelineShaderStageCreateInfo> &shaderStages) {
         _shaderStages = shaderStages;
@@ -139,13 +318,34 @@ namespace Vkxel::VkUtil {
         return *this;
     }
 
+    GraphicsPipelineBuilder &GraphicsPipelineBuilder::SetPipelineCache(const VkPipelineCache pipelineCache) {
+        _pipeline_cache = pipelineCache;
+        return *this;
+    }
+
+    GraphicsPipelineBuilder &GraphicsPipelineBuilder::SetShaderHash(const uint64_t shaderHash) {
+        _shader_hash = shaderHash;
+        return *this;
+    }
+
+    GraphicsPipelineBuilder &GraphicsPipelineBuilder::SetPipelineRegistry(PipelineRegistry &pipelineRegistry) {
+        _pipeline_registry = &pipelineRegistry;
+        return *this;
+    }
+
     GraphicsPipeline
     DefaultGraphicsPipelineBuilder::Build(const std::vector<VkDescriptorSetLayout> &pipelineLayout) const {
         GraphicsPipelineBuilder builder(_device);
 
         builder.SetPipelineLayout(pipelineLayout);
+        builder.SetPipelineCache(PipelineCache::Instance().Get());
 
-        VkShaderModule shader_module = ShaderLoader::Instance().LoadToModule(_device, "graphics");
+        const std::vector<uint8_t> shader_code = ShaderLoader::Instance().LoadToBinary("graphics");
+        VkShaderModule shader_module = CreateShaderModule(_device, shader_code);
+        if (_pipeline_registry) {
+            builder.SetShaderHash(Hash::Span<uint8_t>(shader_code));
+            builder.SetPipelineRegistry(*_pipeline_registry);
+        }
 
         builder.SetShaderStages({
                 VkPipelineShaderStageCreateInfo{.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO,
@@ -227,6 +427,12 @@ namespace Vkxel::VkUtil {
         return *this;
     }
 
+    ComputePipelineBuilder &ComputePipelineBuilder::SetShaderCode(const std::span<const uint8_t> shaderCode) {
+        _shader_code = shaderCode;
+        _shader_hash = Hash::Span(shaderCode);
+        return *this;
+    }
+
     ComputePipelineBuilder &ComputePipelineBuilder::SetShaderName(const std::string_view name) {
         _shader_name = name;
         return *this;
@@ -238,33 +444,112 @@ namespace Vkxel::VkUtil {
         return *this;
     }
 
+    ComputePipelineBuilder &
+    ComputePipelineBuilder::SetSpecializationConstant(const std::vector<uint32_t> &specializationConstant) {
+        _specialization_constant = specializationConstant;
+        return *this;
+    }
+
+    ComputePipelineBuilder &ComputePipelineBuilder::SetPushConstantSize(const uint32_t pushConstantSize) {
+        _push_constant_size = pushConstantSize;
+        return *this;
+    }
+
+    ComputePipelineBuilder &ComputePipelineBuilder::SetPipelineCache(const VkPipelineCache pipelineCache) {
+        _pipeline_cache = pipelineCache;
+        return *this;
+    }
+
+    ComputePipelineBuilder &ComputePipelineBuilder::SetShaderHash(const uint64_t shaderHash) {
+        _shader_hash = shaderHash;
+        return *this;
+    }
+
+    ComputePipelineBuilder &ComputePipelineBuilder::SetPipelineRegistry(PipelineRegistry &pipelineRegistry) {
+        _pipeline_registry = &pipelineRegistry;
+        return *this;
+    }
+
     ComputePipeline ComputePipelineBuilder::Build() const {
+        std::vector<VkPushConstantRange> push_constant_range;
+        if (_push_constant_size > 0) {
+            push_constant_range.push_back(
+                    {.stageFlags = VK_SHADER_STAGE_COMPUTE_BIT, .offset = 0, .size = _push_constant_size});
+        }
+
         VkPipelineLayoutCreateInfo layout_create_info{.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO,
                                                       .setLayoutCount =
                                                               static_cast<uint32_t>(_descriptorSetLayouts.size()),
                                                       .pSetLayouts = _descriptorSetLayouts.data(),
-                                                      .pushConstantRangeCount = 0};
+                                                      .pushConstantRangeCount =
+                                                              static_cast<uint32_t>(push_constant_range.size()),
+                                                      .pPushConstantRanges = push_constant_range.data()};
+
+        if (_pipeline_registry) {
+            CHECK(_shader_hash != 0, "Shared Pipelines Require A Shader Hash");
+            VkPipelineLayout pipeline_layout =
+                    _pipeline_registry->AcquirePipelineLayout(_descriptorSetLayouts, push_constant_range);
+            const uint64_t key = KeyBuilder()
+                                         .Add(pipeline_layout)
+                                         .Add(_shader_hash)
+                                         .AddString(_shader_name)
+                                         .AddSpan(std::span(_specialization_constant))
+                                         .Get();
+            VkPipeline pipeline =
+                    _pipeline_registry->AcquirePipeline(key, [&]() { return CreatePipeline(pipeline_layout); });
+
+            return {.device = _device,
+                    .pipeline = pipeline,
+                    .layout = pipeline_layout,
+                    .layoutCreateInfo = layout_create_info,
+                    .registry = _pipeline_registry};
+        }
 
         VkPipelineLayout pipeline_layout = nullptr;
         CHECK_RESULT_VK(vkCreatePipelineLayout(_device, &layout_create_info, nullptr, &pipeline_layout));
 
+        return {.device = _device,
+                .pipeline = CreatePipeline(pipeline_layout),
+                .layout = pipeline_layout,
+                .layoutCreateInfo = layout_create_info};
+    }
+
+    VkPipeline ComputePipelineBuilder::CreatePipeline(const VkPipelineLayout layout) const {
+        CHECK(_shader || !_shader_code.empty(), "Compute Pipeline Require A Shader");
+        // Only created here so shared pipelines never build a module
+        const VkShaderModule shader_module = _shader ? _shader : CreateShaderModule(_device, _shader_code);
+
+        std::vector<VkSpecializationMapEntry> specialization_map_entry(_specialization_constant.size());
+        for (uint32_t index = 0; auto &entry: specialization_map_entry) {
+            entry = {.constantID = index, .offset = index * sizeof(uint32_t), .size = sizeof(uint32_t)};
+            ++index;
+        }
+
+        VkSpecializationInfo specialization_info{
+                .mapEntryCount = static_cast<uint32_t>(specialization_map_entry.size()),
+                .pMapEntries = specialization_map_entry.data(),
+                .dataSize = _specialization_constant.size() * sizeof(uint32_t),
+                .pData = _specialization_constant.data()};
+
         VkComputePipelineCreateInfo pipeline_create_info{
                 .sType = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO,
                 .stage = VkPipelineShaderStageCreateInfo{.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO,
                                                          .stage = VK_SHADER_STAGE_COMPUTE_BIT,
-                                                         .module = _shader,
+                                                         .module = shader_module,
                                                          .pName = _shader_name.data(),
-                                                         .pSpecializationInfo = nullptr},
-                .layout = pipeline_layout};
+                                                         .pSpecializationInfo = _specialization_constant.empty()
+                                                                                        ? nullptr
+                                                                                        : &specialization_info},
+                .layout = layout};
 
         VkPipeline pipeline = nullptr;
-        CHECK_RESULT_VK(vkCreateComputePipelines(_device, nullptr, 1, &pipeline_create_info, nullptr, &pipeline));
+        CHECK_RESULT_VK(
+                vkCreateComputePipelines(_device, _pipeline_cache, 1, &pipeline_create_info, nullptr, &pipeline));
 
-        return {.device = _device,
-                .pipeline = pipeline,
-                .layout = pipeline_layout,
-                .createInfo = pipeline_create_info,
-                .layoutCreateInfo = layout_create_info};
+        if (shader_module != _shader) {
+            vkDestroyShaderModule(_device, shader_module, nullptr);
+        }
+        return pipeline;
     }
 
 
@@ -5,7 +5,10 @@
 #ifndef VKXEL_PIPELINE_H
 #define VKXEL_PIPELINE_H
 
+#include <cstdint>
+#include <span>
 #include <string>
+#include <string_view>
 #include <vector>
 
 #include "vulkan/vulkan_core.h"
@@ -13,12 +16,16 @@
 
 namespace Vkxel::VkUtil {
 
+    class PipelineRegistry;
+
     struct GraphicsPipeline {
         VkDevice device = nullptr;
         VkPipeline pipeline = nullptr;
         VkPipelineLayout layout = nullptr;
         VkGraphicsPipelineCreateInfo createInfo = {};
         VkPipelineLayoutCreateInfo layoutCreateInfo = {};
+        // Pipeline and layout are shared through the registry when set, Destroy releases one reference
+        PipelineRegistry *registry = nullptr;
 
         void Destroy();
     };
@@ -29,6 +36,8 @@ namespace Vkxel::VkUtil {
         VkPipelineLayout layout = nullptr;
         VkComputePipelineCreateInfo createInfo = {};
         VkPipelineLayoutCreateInfo layoutCreateInfo = {};
+        // Pipeline and layout are shared through the registry when set, Destroy releases one reference
+        PipelineRegistry *registry = nullptr;
 
         void Destroy();
     };
@@ -50,9 +59,20 @@ namespace Vkxel::VkUtil {
         GraphicsPipelineBuilder &SetColorBlendState(const VkPipelineColorBlendStateCreateInfo &colorBlending);
         GraphicsPipelineBuilder &SetDynamicState(const VkPipelineDynamicStateCreateInfo &dynamicState);
         GraphicsPipelineBuilder &SetDynamicRendering(const VkPipelineRenderingCreateInfo &pipelineRendering);
+        GraphicsPipelineBuilder &SetPipelineCache(VkPipelineCache pipelineCache);
+        // Content hash of the SPIR-V behind every shader stage, required to share pipelines through a registry
+        GraphicsPipelineBuilder &SetShaderHash(uint64_t shaderHash);
+        GraphicsPipelineBuilder &SetPipelineRegistry(PipelineRegistry &pipelineRegistry);
 
     protected:
+        // Every state the pipeline is built from except shader modules, which are covered by the shader hash
+        uint64_t GetKey(VkPipelineLayout layout) const;
+        VkGraphicsPipelineCreateInfo GetCreateInfo(VkPipelineLayout layout) const;
+
         VkDevice _device = nullptr;
+        VkPipelineCache _pipeline_cache = nullptr;
+        PipelineRegistry *_pipeline_registry = nullptr;
+        uint64_t _shader_hash = 0;
         std::vector<VkPipelineShaderStageCreateInfo> _shaderStages{};
         std::vector<VkDescriptorSetLayout> _descriptorSetLayouts{};
 
@@ -147,11 +167,13 @@ namespace Vkxel::VkUtil {
 
     class DefaultGraphicsPipelineBuilder {
     public:
-        explicit DefaultGraphicsPipelineBuilder(const VkDevice device) : _device(device) {}
+        explicit DefaultGraphicsPipelineBuilder(const VkDevice device, PipelineRegistry *pipelineRegistry = nullptr) :
+            _device(device), _pipeline_registry(pipelineRegistry) {}
         GraphicsPipeline Build(const std::vector<VkDescriptorSetLayout> &pipelineLayout) const;
 
     private:
         VkDevice _device = nullptr;
+        PipelineRegistry *_pipeline_registry = nullptr;
     };
 
     class ComputePipelineBuilder {
@@ -161,14 +183,33 @@ namespace Vkxel::VkUtil {
         ComputePipeline Build() const;
 
         ComputePipelineBuilder &SetShader(const VkShaderModule shader);
+        // SPIR-V the module is created from, only when the pipeline is not already in the registry,
+        // the code has to outlive Build and also sets the shader hash
+        ComputePipelineBuilder &SetShaderCode(std::span<const uint8_t> shaderCode);
         ComputePipelineBuilder &SetShaderName(const std::string_view name);
         ComputePipelineBuilder &SetPipelineLayout(const std::vector<VkDescriptorSetLayout> &pipelineLayout);
+        // 32-bit specialization constants, constant_id is the index in the vector
+        ComputePipelineBuilder &SetSpecializationConstant(const std::vector<uint32_t> &specializationConstant);
+        // Single push constant range at offset 0 visible to the compute stage, 0 disables push constants
+        ComputePipelineBuilder &SetPushConstantSize(uint32_t pushConstantSize);
+        ComputePipelineBuilder &SetPipelineCache(VkPipelineCache pipelineCache);
+        // Content hash of the shader SPIR-V, required to share pipelines through a registry
+        ComputePipelineBuilder &SetShaderHash(uint64_t shaderHash);
+        ComputePipelineBuilder &SetPipelineRegistry(PipelineRegistry &pipelineRegistry);
 
     private:
+        VkPipeline CreatePipeline(VkPipelineLayout layout) const;
+
         VkDevice _device = nullptr;
+        VkPipelineCache _pipeline_cache = nullptr;
+        PipelineRegistry *_pipeline_registry = nullptr;
         VkShaderModule _shader = nullptr;
+        std::span<const uint8_t> _shader_code = {};
+        uint64_t _shader_hash = 0;
         std::string _shader_name = {};
         std::vector<VkDescriptorSetLayout> _descriptorSetLayouts = {};
+        std::vector<uint32_t> _specialization_constant = {};
+        uint32_t _push_constant_size = 0;
     };
 
 } // namespace Vkxel::VkUtil
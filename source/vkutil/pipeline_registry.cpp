@@ -0,0 +1,145 @@
+//
+// Created by jiayi on 10/19/2026.
+//
+
+#include <functional>
+#include <mutex>
+#include <ranges>
+#include <vector>
+
+#include "pipeline_registry.h"
+#include "util/check.h"
+#include "util/hash.hpp"
+
+namespace Vkxel::VkUtil {
+
+    VkDescriptorSetLayout
+    PipelineRegistry::AcquireDescriptorSetLayout(const std::vector<VkDescriptorSetLayoutBinding> &bindings) {
+        // Field by field, struct padding is not guaranteed to be zero
+        uint64_t key = Hash::Value(bindings.size());
+        for (const auto &binding: bindings) {
+            key = Hash::Value(binding.binding, key);
+            key = Hash::Value(binding.descriptorType, key);
+            key = Hash::Value(binding.descriptorCount, key);
+            key = Hash::Value(binding.stageFlags, key);
+            key = Hash::Value(binding.pImmutableSamplers, key);
+        }
+
+        std::scoped_lock lock(_mutex);
+        return Acquire<VkDescriptorSetLayout>(_descriptor_set_layout, key, [&]() {
+            VkDescriptorSetLayoutCreateInfo descriptor_set_layout_create_info{
+                    .sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO,
+                    .bindingCount = static_cast<uint32_t>(bindings.size()),
+                    .pBindings = bindings.data()};
+            VkDescriptorSetLayout layout = nullptr;
+            CHECK_RESULT_VK(vkCreateDescriptorSetLayout(_device, &descriptor_set_layout_create_info, nullptr, &layout));
+            return layout;
+        });
+    }
+
+    void PipelineRegistry::ReleaseDescriptorSetLayout(const VkDescriptorSetLayout layout) {
+        std::scoped_lock lock(_mutex);
+        if (Release(_descriptor_set_layout, layout)) {
+            vkDestroyDescriptorSetLayout(_device, layout, nullptr);
+        }
+    }
+
+    VkPipelineLayout
+    PipelineRegistry::AcquirePipelineLayout(const std::vector<VkDescriptorSetLayout> &setLayouts,
+                                            const std::vector<VkPushConstantRange> &pushConstantRanges) {
+        uint64_t key = Hash::Value(setLayouts.size());
+        for (const VkDescriptorSetLayout layout: setLayouts) {
+            key = Hash::Value(layout, key);
+        }
+        key = Hash::Value(pushConstantRanges.size(), key);
+        for (const auto &range: pushConstantRanges) {
+            key = Hash::Value(range.stageFlags, key);
+            key = Hash::Value(range.offset, key);
+            key = Hash::Value(range.size, key);
+        }
+
+        std::scoped_lock lock(_mutex);
+        return Acquire<VkPipelineLayout>(_pipeline_layout, key, [&]() {
+            VkPipelineLayoutCreateInfo layout_create_info{
+                    .sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO,
+                    .setLayoutCount = static_cast<uint32_t>(setLayouts.size()),
+                    .pSetLayouts = setLayouts.data(),
+                    .pushConstantRangeCount = static_cast<uint32_t>(pushConstantRanges.size()),
+                    .pPushConstantRanges = pushConstantRanges.data()};
+            VkPipelineLayout layout = nullptr;
+            CHECK_RESULT_VK(vkCreatePipelineLayout(_device, &layout_create_info, nullptr, &layout));
+            return layout;
+        });
+    }
+
+    void PipelineRegistry::ReleasePipelineLayout(const VkPipelineLayout layout) {
+        std::scoped_lock lock(_mutex);
+        if (Release(_pipeline_layout, layout)) {
+            vkDestroyPipelineLayout(_device, layout, nullptr);
+        }
+    }
+
+    VkPipeline PipelineRegistry::AcquirePipeline(const uint64_t key, const std::function<VkPipeline()> &create) {
+        std::scoped_lock lock(_mutex);
+        return Acquire(_pipeline, key, create);
+    }
+
+    void PipelineRegistry::ReleasePipeline(const VkPipeline pipeline) {
+        std::scoped_lock lock(_mutex);
+        if (Release(_pipeline, pipeline)) {
+            vkDestroyPipeline(_device, pipeline, nullptr);
+        }
+    }
+
+    size_t PipelineRegistry::GetPipelineCount() const {
+        std::scoped_lock lock(_mutex);
+        return _pipeline.entry.size();
+    }
+
+    void PipelineRegistry::Destroy() {
+        std::scoped_lock lock(_mutex);
+        for (const auto &[handle, reference_count]: _pipeline.entry | std::views::values) {
+            vkDestroyPipeline(_device, handle, nullptr);
+        }
+        for (const auto &[handle, reference_count]: _pipeline_layout.entry | std::views::values) {
+            vkDestroyPipelineLayout(_device, handle, nullptr);
+        }
+        for (const auto &[handle, reference_count]: _descriptor_set_layout.entry | std::views::values) {
+            vkDestroyDescriptorSetLayout(_device, handle, nullptr);
+        }
+        _pipeline = {};
+        _pipeline_layout = {};
+        _descriptor_set_layout = {};
+    }
+
+    template<typename T>
+    T PipelineRegistry::Acquire(Table<T> &table, const uint64_t key, const std::function<T()> &create) {
+        if (const auto it = table.entry.find(key); it != table.entry.end()) {
+            ++it->second.referenceCount;
+            return it->second.handle;
+        }
+
+        T handle = create();
+        table.entry.emplace(key, Entry<T>{.handle = handle, .referenceCount = 1});
+        table.key.emplace(handle, key);
+        return handle;
+    }
+
+    template<typename T>
+    bool PipelineRegistry::Release(Table<T> &table, const T handle) {
+        const auto key = table.key.find(handle);
+        if (key == table.key.end()) {
+            return false;
+        }
+
+        const auto entry = table.entry.find(key->second);
+        if (--entry->second.referenceCount > 0) {
+            return false;
+        }
+
+        table.entry.erase(entry);
+        table.key.erase(key);
+        return true;
+    }
+
+} // namespace Vkxel::VkUtil
@@ -0,0 +1,71 @@
+//
+// Created by jiayi on 10/19/2026.
+//
+
+#ifndef VKXEL_PIPELINE_REGISTRY_H
+#define VKXEL_PIPELINE_REGISTRY_H
+
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+#include "vulkan/vulkan.h"
+
+namespace Vkxel::VkUtil {
+
+    // Content-hashed descriptor set layouts, pipeline layouts and pipelines, identical requests share one reference
+    // counted handle that is destroyed with its last release
+    class PipelineRegistry {
+    public:
+        explicit PipelineRegistry(const VkDevice device) : _device(device) {}
+
+        VkDescriptorSetLayout AcquireDescriptorSetLayout(const std::vector<VkDescriptorSetLayoutBinding> &bindings);
+        void ReleaseDescriptorSetLayout(VkDescriptorSetLayout layout);
+
+        // Set layouts are keyed by handle, so they should come from AcquireDescriptorSetLayout to be shared
+        VkPipelineLayout AcquirePipelineLayout(const std::vector<VkDescriptorSetLayout> &setLayouts,
+                                               const std::vector<VkPushConstantRange> &pushConstantRanges);
+        void ReleasePipelineLayout(VkPipelineLayout layout);
+
+        // Key covers everything the pipeline is built from, create is only called when the key is new
+        VkPipeline AcquirePipeline(uint64_t key, const std::function<VkPipeline()> &create);
+        void ReleasePipeline(VkPipeline pipeline);
+
+        size_t GetPipelineCount() const;
+
+        // Destroy every handle regardless of references, later releases are ignored
+        void Destroy();
+
+    private:
+        template<typename T>
+        struct Entry {
+            T handle;
+            uint32_t referenceCount;
+        };
+
+        template<typename T>
+        struct Table {
+            std::unordered_map<uint64_t, Entry<T>> entry = {};
+            std::unordered_map<T, uint64_t> key = {};
+        };
+
+        // Handle of key with one more reference, created on first use
+        template<typename T>
+        static T Acquire(Table<T> &table, uint64_t key, const std::function<T()> &create);
+        // True when the last reference was released and the handle has to be destroyed
+        template<typename T>
+        static bool Release(Table<T> &table, T handle);
+
+        VkDevice _device = nullptr;
+
+        mutable std::mutex _mutex;
+        Table<VkDescriptorSetLayout> _descriptor_set_layout;
+        Table<VkPipelineLayout> _pipeline_layout;
+        Table<VkPipeline> _pipeline;
+    };
+
+} // namespace Vkxel::VkUtil
+
+#endif // VKXEL_PIPELINE_REGISTRY_H
@@ -0,0 +1,67 @@
+//
+// Created by jiayi on 10/19/2026.
+//
+
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <vector>
+
+#include "glm/glm.hpp"
+
+#include "entry/model_library.h"
+#include "util/debug.hpp"
+
+using namespace Vkxel;
+
+namespace {
+    // Bound documented on ModelLibrary::StanfordBunnyBatchSDF, the fallback outside the unit sphere is exact
+    constexpr float inside_tolerance = 2e-6f;
+    constexpr uint32_t lattice_resolution = 24;
+    // Not a multiple of the lane count, so a partial batch is covered as well
+    constexpr size_t partial_batch_size = 13;
+
+    // Compare every point of batch against StanfordBunnySDF, return the number of points out of bound
+    size_t CheckBatch(const std::vector<glm::vec3> &p, const std::vector<float> &value) {
+        size_t failure_count = 0;
+        for (size_t index = 0; index < p.size(); ++index) {
+            const float expected = ModelLibrary::StanfordBunnySDF(p[index]);
+            const float tolerance = glm::length(p[index]) > 1.0f ? 0.0f : inside_tolerance;
+            if (!(std::abs(value[index] - expected) <= tolerance)) {
+                Debug::LogError("StanfordBunnyBatchSDF({}, {}, {}) = {}, StanfordBunnySDF = {}", p[index].x,
+                                p[index].y, p[index].z, value[index], expected);
+                ++failure_count;
+            }
+        }
+        return failure_count;
+    }
+} // namespace
+
+int main() {
+    // Lattice covering the trained unit sphere and the bounding sphere fallback around it
+    std::vector<glm::vec3> p;
+    p.reserve(lattice_resolution * lattice_resolution * lattice_resolution);
+    for (uint32_t x = 0; x < lattice_resolution; ++x) {
+        for (uint32_t y = 0; y < lattice_resolution; ++y) {
+            for (uint32_t z = 0; z < lattice_resolution; ++z) {
+                p.push_back(glm::vec3(x, y, z) / static_cast<float>(lattice_resolution - 1) * 2.4f - 1.2f);
+            }
+        }
+    }
+
+    std::vector<float> value(p.size());
+    ModelLibrary::StanfordBunnyBatchSDF(p, value);
+    size_t failure_count = CheckBatch(p, value);
+
+    std::vector<glm::vec3> partial_p(p.begin() + p.size() / 2, p.begin() + p.size() / 2 + partial_batch_size);
+    std::vector<float> partial_value(partial_p.size());
+    ModelLibrary::StanfordBunnyBatchSDF(partial_p, partial_value);
+    failure_count += CheckBatch(partial_p, partial_value);
+
+    if (failure_count > 0) {
+        Debug::LogError("{} Of {} Points Out Of Bound", failure_count, p.size() + partial_p.size());
+        return EXIT_FAILURE;
+    }
+    Debug::LogInfo("{} Points Within Bound", p.size() + partial_p.size());
+    return EXIT_SUCCESS;
+}